@@ -0,0 +1,25 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include "../Tools/LogLinearHistogram.hpp"
+
+namespace api {
+
+using json = nlohmann::json;
+
+// ------------------------------------------------------------
+// LogLinearHistogram summary, in the histogram's own unit
+// ------------------------------------------------------------
+inline json histogramSummaryToJson(const tools::LogLinearHistogram::Summary& s) {
+    return json{
+        {"count", s.count},
+        {"p50", s.p50},
+        {"p90", s.p90},
+        {"p99", s.p99},
+        {"max", s.max},
+        {"mean", s.mean}
+    };
+}
+
+} // namespace api
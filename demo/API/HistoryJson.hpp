@@ -0,0 +1,119 @@
+#pragma once
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "../GlobalState.hpp"
+#include "../Tools/DateTime.hpp"
+#include "../Tools/HistoryRing.hpp"
+
+namespace api {
+
+using json = nlohmann::json;
+
+// ------------------------------------------------------------
+// Helpers
+// ------------------------------------------------------------
+inline bool parseHistoryTier(const std::string& s, tools::HistoryTier& out) {
+    using T = tools::HistoryTier;
+    if (s == "raw") { out = T::RAW;  return true; }
+    if (s == "1s")  { out = T::SEC;  return true; }
+    if (s == "1m")  { out = T::MIN;  return true; }
+    if (s == "1h")  { out = T::HOUR; return true; }
+    return false;
+}
+
+inline json historyPointToJson(const tools::HistoryPoint& p, tools::HistoryTier t) {
+    if (t == tools::HistoryTier::RAW) {
+        return json{{"t", p.stampMs}, {"v", p.avg}};
+    }
+    return json{
+        {"t", p.stampMs},
+        {"min", p.min},
+        {"max", p.max},
+        {"avg", p.avg},
+        {"n", p.count}
+    };
+}
+
+// ------------------------------------------------------------
+// GET history/keys
+// ------------------------------------------------------------
+inline json historyKeysJson(const GH_GlobalState& gs) {
+    json j;
+    j["keys"] = json::array();
+
+    const auto snap = gs.getterSnapshot();
+    for (uint32_t slot = 0; slot < snap->slots.size(); ++slot) {
+        const auto* h = gs.getterHistory(GH_GlobalState::GetterHandle{slot});
+        if (!h) continue;
+
+        json k;
+        k["key"] = snap->slots[slot]->key;
+
+        for (size_t i = 0; i < tools::kHistoryTiers; ++i) {
+            const auto t = static_cast<tools::HistoryTier>(i);
+            const auto& ring = h->ring(t);
+
+            k["tiers"][tools::toString(t)] = {
+                {"size", ring.size()},
+                {"capacity", ring.capacity()},
+                {"oldestMs", ring.oldestMs()}
+            };
+        }
+
+        j["keys"].push_back(std::move(k));
+    }
+
+    return j;
+}
+
+// ------------------------------------------------------------
+// POST history/query
+// body: { "key": "temp", "from": <unix ms>, "to": <unix ms>,
+//         "tier": "auto"|"raw"|"1s"|"1m"|"1h", "limit": N }
+// from defaults to one hour ago, to to now.
+// ------------------------------------------------------------
+inline json historyQueryJson(const GH_GlobalState& gs, const json& body) {
+    if (!body.is_object() || !body.contains("key") || !body["key"].is_string()) {
+        throw std::runtime_error("history/query: \"key\" is required");
+    }
+
+    const std::string key = body["key"].get<std::string>();
+    const auto* h = gs.getterHistory(key);
+    if (!h) {
+        throw std::runtime_error("history/query: no history for getter: " + key);
+    }
+
+    const long long now = tools::nowUnixMs();
+    const long long from = body.value("from", now - 60LL * 60 * 1000);
+    const long long to = body.value("to", std::numeric_limits<long long>::max());
+    const size_t limit = body.value("limit", size_t{0});
+
+    const std::string tierStr = body.value("tier", std::string("auto"));
+
+    tools::HistoryTier tier = tools::HistoryTier::RAW;
+    if (tierStr == "auto") {
+        tier = h->pickTier(from);
+    } else if (!parseHistoryTier(tierStr, tier)) {
+        throw std::runtime_error("history/query: unknown tier: " + tierStr);
+    }
+
+    json j;
+    j["key"] = key;
+    j["tier"] = tools::toString(tier);
+    j["from"] = from;
+    j["to"] = to;
+    j["points"] = json::array();
+
+    for (const auto& p : h->query(tier, from, to, limit)) {
+        j["points"].push_back(historyPointToJson(p, tier));
+    }
+
+    return j;
+}
+
+} // namespace api
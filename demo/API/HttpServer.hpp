@@ -10,9 +10,11 @@
 #include <functional>
 #include <fstream>
 #include <sstream>
+#include <mutex>
 
 #include "../GlobalState.hpp"
 #include "../Tools/DateTime.hpp"
+#include "../Storage/TimeSeriesStore.hpp"
 #include "JsonAPI.hpp"
 #include <nlohmann/json.hpp>
 
@@ -60,35 +62,27 @@ static inline std::string jescape(const std::string& s) {
     return out;
 }
 
-static inline std::string any_to_json(const std::any& a) {
-    if (!a.has_value())
-        return "{\"type\":\"null\",\"value\":null}";
+static inline std::string value_to_json(const GH_GlobalState::Value& v) {
+    using VT = GH_GlobalState::ValueType;
 
-    const auto& t = a.type();
+    if (!v.hasValue())
+        return "{\"type\":\"null\",\"value\":null}";
 
-    if (t == typeid(bool)) {
-        bool v = std::any_cast<bool>(a);
-        return std::string("{\"type\":\"bool\",\"value\":") + (v ? "true}" : "false}");
-    }
-    if (t == typeid(int)) {
-        int v = std::any_cast<int>(a);
-        return "{\"type\":\"int\",\"value\":" + std::to_string(v) + "}";
-    }
-    if (t == typeid(double)) {
-        double v = std::any_cast<double>(a);
-        return "{\"type\":\"double\",\"value\":" + std::to_string(v) + "}";
-    }
-    if (t == typeid(std::string)) {
-        std::string v = jescape(std::any_cast<std::string>(a));
-        return "{\"type\":\"string\",\"value\":\"" + v + "\"}";
-    }
-    if (t == typeid(tools::UnixMs)) {
-        const auto& v = std::any_cast<const tools::UnixMs&>(a);
-        return std::string("{\"type\":\"time\",\"value\":")
-            + std::to_string(v.value)
-            + ",\"formatted\":\""
-            + jescape(tools::unixMsToString(v.value))
-            + "\"}";
+    switch (v.type) {
+        case VT::BOOL:
+            return std::string("{\"type\":\"bool\",\"value\":") + (v.num.b ? "true}" : "false}");
+        case VT::INT:
+            return "{\"type\":\"int\",\"value\":" + std::to_string(v.num.i) + "}";
+        case VT::DOUBLE:
+            return "{\"type\":\"double\",\"value\":" + std::to_string(v.num.d) + "}";
+        case VT::STRING:
+            return "{\"type\":\"string\",\"value\":\"" + jescape(v.str) + "\"}";
+        case VT::TIME:
+            return std::string("{\"type\":\"time\",\"value\":")
+                + std::to_string(v.num.ms)
+                + ",\"formatted\":\""
+                + jescape(tools::unixMsToString(v.num.ms))
+                + "\"}";
     }
 
     return "{\"type\":\"unknown\",\"value\":null}";
@@ -101,6 +95,7 @@ static inline std::string valueTypeToStr(GH_GlobalState::ValueType vt) {
         case VT::INT:    return "int";
         case VT::DOUBLE: return "double";
         case VT::STRING: return "string";
+        case VT::TIME:   return "time";
     }
     return "unknown";
 }
@@ -116,7 +111,7 @@ static inline std::string desired_to_json(const GH_GlobalState::ExecDesiredEntry
     out += ",\"mode\":" + mode_to_json(e.mode);
     out += ",\"stampMs\":" + std::to_string(e.stampMs);
     out += ",\"lastWriter\":\"" + jescape(e.lastWriter) + "\"";
-    out += ",\"data\":" + any_to_json(e.value);
+    out += ",\"data\":" + value_to_json(e.value);
     out += "}";
     return out;
 }
@@ -129,11 +124,92 @@ static inline std::string actual_to_json(const GH_GlobalState::ExecActualEntry&
     out += ",\"stampMs\":" + std::to_string(e.stampMs);
     out += ",\"lastAppliedMs\":" + std::to_string(e.lastAppliedMs);
     out += ",\"lastError\":\"" + jescape(e.lastError) + "\"";
-    out += ",\"data\":" + any_to_json(e.value);
+    out += ",\"data\":" + value_to_json(e.value);
+    out += "}";
+    return out;
+}
+
+static inline std::string getter_record_to_json(const GH_GlobalState::GetterRecord& r) {
+    std::string out = "\"" + jescape(r.key) + "\":{";
+    out += "\"valid\":" + std::string(r.entry.valid ? "true" : "false");
+    out += ",\"stampMs\":" + std::to_string(r.entry.stampMs);
+    out += ",\"data\":" + value_to_json(r.entry.value);
+    out += "}";
+    return out;
+}
+
+static inline std::string exec_record_to_json(const GH_GlobalState::ExecRecord& r) {
+    const auto& a = r.state.actual;
+
+    std::string out = "{";
+    out += "\"id\":" + std::to_string(r.id);
+    out += ",\"name\":\"" + jescape(r.name) + "\"";
+    out += ",\"valid\":" + std::string(a.valid ? "true" : "false");
+    out += ",\"stampMs\":" + std::to_string(a.stampMs);
+    out += ",\"mode\":\"" + jescape(toString(a.mode)) + "\"";
+    out += ",\"data\":" + value_to_json(a.value);
+    out += ",\"desired\":" + desired_to_json(r.state.desired);
+    out += ",\"actual\":" + actual_to_json(a);
     out += "}";
     return out;
 }
 
+template<class Records>
+static inline std::string getters_to_json(const Records& records) {
+    std::string out = "{";
+    bool first = true;
+    for (const auto& r : records) {
+        if (!first) out += ",";
+        first = false;
+        out += getter_record_to_json(*r);
+    }
+    out += "}";
+    return out;
+}
+
+template<class Records>
+static inline std::string executors_to_json(const Records& records) {
+    std::string out = "[";
+    bool first = true;
+    for (const auto& r : records) {
+        if (!first) out += ",";
+        first = false;
+        out += exec_record_to_json(*r);
+    }
+    out += "]";
+    return out;
+}
+
+// ------------------------------------------------------------
+// Serialized body cache keyed by snapshot version.
+// Polling clients hit this far more often than state changes,
+// so an unchanged table is served without re-serializing.
+// ------------------------------------------------------------
+struct SnapshotBodyCache {
+    template<class Build>
+    std::string get(uint64_t version, Build&& build) {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (filled && version == cachedVersion) return body;
+        }
+
+        std::string fresh = build();
+
+        std::lock_guard<std::mutex> lk(mtx);
+        if (!filled || version >= cachedVersion) {
+            filled = true;
+            cachedVersion = version;
+            body = fresh;
+        }
+        return fresh;
+    }
+
+    std::mutex mtx;
+    bool filled{false};
+    uint64_t cachedVersion{0};
+    std::string body;
+};
+
 static inline http::response<http::string_body>
 make_json(http::request<http::string_body> const& req, http::status st, const std::string& body) {
     http::response<http::string_body> res{st, req.version()};
@@ -156,6 +232,60 @@ make_text(http::request<http::string_body> const& req, http::status st, const st
     return res;
 }
 
+// ------------------------------------------------------------
+// Query string helpers
+// ------------------------------------------------------------
+static inline std::string target_path(const std::string& target) {
+    return target.substr(0, target.find('?'));
+}
+
+// %XX escapes and '+' (form encoding) decoded; a malformed escape
+// is kept as is
+static inline std::string url_decode(const std::string& s) {
+    auto hex = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        const char c = s[i];
+        if (c == '+') {
+            out += ' ';
+        } else if (c == '%' && i + 2 < s.size() && hex(s[i + 1]) >= 0 && hex(s[i + 2]) >= 0) {
+            out += static_cast<char>(hex(s[i + 1]) * 16 + hex(s[i + 2]));
+            i += 2;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// Decoded value of the first name=value pair matching name.
+static inline bool query_param(const std::string& target, const std::string& name, std::string& out) {
+    const auto q = target.find('?');
+    if (q == std::string::npos) return false;
+
+    size_t i = q + 1;
+    while (i <= target.size()) {
+        size_t end = target.find('&', i);
+        if (end == std::string::npos) end = target.size();
+
+        const std::string kv = target.substr(i, end - i);
+        const auto eq = kv.find('=');
+        if (url_decode(kv.substr(0, eq)) == name) {
+            out = (eq == std::string::npos) ? std::string() : url_decode(kv.substr(eq + 1));
+            return true;
+        }
+        i = end + 1;
+    }
+    return false;
+}
+
 // ------------------------------------------------------------
 // Simple JSON parser
 // ------------------------------------------------------------
@@ -230,6 +360,7 @@ handle_request(http::request<http::string_body>&& req,
                const CommandHandler& cmdHandler,
                const api::JsonApi* jsonApi) {
     const std::string target = std::string(req.target());
+    const std::string path = target_path(target);
     const auto method = req.method();
     auto& st = GH_GlobalState::instance();
 
@@ -263,33 +394,48 @@ handle_request(http::request<http::string_body>&& req,
         return make_json(req, http::status::ok, out);
     }
 
-    if (method == http::verb::get && target == "/getters") {
-        auto mp = st.snapshotGetters();
-        std::string out = "{";
-        bool first = true;
-        for (const auto& kv : mp) {
-            if (!first) out += ",";
-            first = false;
-
-            out += "\"" + jescape(kv.first) + "\":{";
-            out += "\"valid\":" + std::string(kv.second.valid ? "true" : "false");
-            out += ",\"stampMs\":" + std::to_string(kv.second.stampMs);
-            out += ",\"data\":" + any_to_json(kv.second.value);
-            out += "}";
+    // GET /getters?since=<version>  -> {"version":V,"changed":{...}}
+    // GET /executors?since=<version> -> {"version":V,"changed":[...]}
+    // any other query string falls through to the full snapshot
+    std::string sinceStr;
+    if (method == http::verb::get && (path == "/getters" || path == "/executors") &&
+        query_param(target, "since", sinceStr)) {
+        uint64_t since = 0;
+        try {
+            since = std::stoull(sinceStr);
+        } catch (...) {
+            return make_json(req, http::status::bad_request, "{\"error\":\"bad since\"}");
         }
+
+        // versions restart with the process; clients drop their copy
+        // and re-read from 0 when epoch changes
+        static const long long epoch = tools::nowUnixMs();
+
+        const auto delta = st.snapshotSince(since);
+        std::string out = "{\"epoch\":" + std::to_string(epoch);
+        out += ",\"version\":" + std::to_string(delta.version) + ",\"changed\":";
+        out += (path == "/getters") ? getters_to_json(delta.getters)
+                                    : executors_to_json(delta.executors);
         out += "}";
         return make_json(req, http::status::ok, out);
     }
 
-    if (method == http::verb::get && target.rfind("/getters/", 0) == 0) {
-        const std::string key = target.substr(std::string("/getters/").size());
+    if (method == http::verb::get && path == "/getters") {
+        static SnapshotBodyCache cache;
+        auto snap = st.getterSnapshot();
+        return make_json(req, http::status::ok,
+            cache.get(snap->version, [&] { return getters_to_json(snap->slots); }));
+    }
+
+    if (method == http::verb::get && path.rfind("/getters/", 0) == 0) {
+        const std::string key = url_decode(path.substr(std::string("/getters/").size()));
         try {
             auto e = st.getGetterEntry(key);
             std::string out = "{";
             out += "\"key\":\"" + jescape(key) + "\"";
             out += ",\"valid\":" + std::string(e.valid ? "true" : "false");
             out += ",\"stampMs\":" + std::to_string(e.stampMs);
-            out += ",\"data\":" + any_to_json(e.value);
+            out += ",\"data\":" + value_to_json(e.value);
             out += "}";
             return make_json(req, http::status::ok, out);
         } catch (const std::exception& ex) {
@@ -298,27 +444,84 @@ handle_request(http::request<http::string_body>&& req,
         }
     }
 
-    if (method == http::verb::get && target == "/executors") {
-        auto v = st.snapshotExecutors();
-        std::string out = "[";
-        bool first = true;
-        for (const auto& e : v) {
-            if (!first) out += ",";
-            first = false;
+    if (method == http::verb::get && path == "/executors") {
+        static SnapshotBodyCache cache;
+        auto snap = st.execSnapshot();
+        return make_json(req, http::status::ok,
+            cache.get(snap->version, [&] { return executors_to_json(snap->slots); }));
+    }
 
-            out += "{";
-            out += "\"id\":" + std::to_string(e.id);
-            out += ",\"name\":\"" + jescape(e.name) + "\"";
-            out += ",\"valid\":" + std::string(e.entry.valid ? "true" : "false");
-            out += ",\"stampMs\":" + std::to_string(e.entry.stampMs);
-            out += ",\"mode\":\"" + jescape(toString(e.entry.mode)) + "\"";
-            out += ",\"data\":" + any_to_json(e.entry.value);
-            out += ",\"desired\":" + desired_to_json(e.desired);
-            out += ",\"actual\":" + actual_to_json(e.actual);
-            out += "}";
+    // --------------------------------------------------------
+    // Persistent history (storage::TimeSeriesStore)
+    // GET /api/history                                  -> series list
+    // GET /api/history?key=K[&from&to&limit]            -> raw points
+    // GET /api/history?key=K&step=<ms>[&from&to]        -> min/max/avg buckets
+    // from/to are unix ms, default: last 24 h
+    // --------------------------------------------------------
+    if (method == http::verb::get && path == "/api/history") {
+        auto& tsdb = storage::TimeSeriesStore::instance();
+        if (!tsdb.isOpen()) {
+            return make_json(req, http::status::service_unavailable,
+                "{\"error\":\"history store is not configured\"}");
+        }
+
+        std::string key;
+        if (!query_param(target, "key", key)) {
+            std::string out = "{\"series\":[";
+            bool first = true;
+            for (const auto& name : tsdb.listSeries()) {
+                if (!first) out += ",";
+                first = false;
+                out += "\"" + jescape(name) + "\"";
+            }
+            out += "]}";
+            return make_json(req, http::status::ok, out);
+        }
+
+        try {
+            auto num = [&](const char* name, long long def) {
+                std::string v;
+                return query_param(target, name, v) ? std::stoll(v) : def;
+            };
+
+            const long long now = tools::nowUnixMs();
+            const long long from = num("from", now - 24LL * 60 * 60 * 1000);
+            const long long to = num("to", now);
+            const long long step = num("step", -1);
+            const long long limit = num("limit", 10000);
+
+            std::string out = "{\"key\":\"" + jescape(key) + "\"";
+            out += ",\"from\":" + std::to_string(from);
+            out += ",\"to\":" + std::to_string(to);
+
+            if (step >= 0) {
+                out += ",\"step\":" + std::to_string(step) + ",\"buckets\":[";
+                bool first = true;
+                for (const auto& a : tsdb.aggregate(key, from, to, step)) {
+                    if (!first) out += ",";
+                    first = false;
+                    out += "{\"t\":" + std::to_string(a.stampMs);
+                    out += ",\"min\":" + std::to_string(a.min);
+                    out += ",\"max\":" + std::to_string(a.max);
+                    out += ",\"avg\":" + std::to_string(a.avg());
+                    out += ",\"n\":" + std::to_string(a.count) + "}";
+                }
+            } else {
+                out += ",\"points\":[";
+                bool first = true;
+                const size_t lim = limit > 0 ? static_cast<size_t>(limit) : 0;
+                for (const auto& p : tsdb.query(key, from, to, lim)) {
+                    if (!first) out += ",";
+                    first = false;
+                    out += "[" + std::to_string(p.stampMs) + "," + std::to_string(p.value) + "]";
+                }
+            }
+            out += "]}";
+            return make_json(req, http::status::ok, out);
+        } catch (const std::exception& ex) {
+            return make_json(req, http::status::bad_request,
+                std::string("{\"error\":\"") + jescape(ex.what()) + "\"}");
         }
-        out += "]";
-        return make_json(req, http::status::ok, out);
     }
 
     // --------------------------------------------------------
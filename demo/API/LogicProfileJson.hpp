@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "../Logic/RuleEngine.hpp"
+#include "HistogramJson.hpp"
+
+namespace api {
+
+using json = nlohmann::json;
+
+constexpr size_t kLogicProfileTop = 20;
+
+// ------------------------------------------------------------
+// Helpers
+// ------------------------------------------------------------
+
+// "root/zone_1/vent": titles from the root down
+inline std::string logicNodePath(const logic::RuleProgram& program, uint32_t index) {
+    const auto& instrs = program.instrs();
+
+    std::vector<uint32_t> chain;
+    for (uint32_t i = index; i != logic::RuleProgram::kNoParent; i = instrs[i].parent) {
+        chain.push_back(i);
+    }
+
+    std::string path;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (!path.empty()) path += "/";
+        path += instrs[*it].node->title();
+    }
+    return path;
+}
+
+// ------------------------------------------------------------
+// GET logic/profile
+// Tick time in microseconds, then the nodes with the most time in
+// evaluate(), costliest first. Call under the logic tick lock.
+// ------------------------------------------------------------
+inline json logicProfileJson(const logic::RuleEngine& engine, size_t top = kLogicProfileTop) {
+    const auto& prof = engine.profile();
+    const auto& program = engine.program();
+    const auto& instrs = program.instrs();
+
+    std::vector<uint32_t> order;
+    uint64_t totalNs = 0;
+    if (prof.size() == instrs.size()) {
+        order.resize(prof.size());
+        std::iota(order.begin(), order.end(), 0u);
+        for (const auto& p : prof) totalNs += p.totalNs;
+    }
+
+    const size_t n = std::min(top, order.size());
+    std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(n), order.end(),
+                      [&](uint32_t a, uint32_t b) {
+                          if (prof[a].totalNs != prof[b].totalNs) return prof[a].totalNs > prof[b].totalNs;
+                          return a < b;
+                      });
+
+    json j;
+    j["enabled"] = engine.profiling();
+    j["nodes"] = instrs.size();
+    j["tickUs"] = histogramSummaryToJson(engine.tickUs().summary());
+    j["totalNs"] = totalNs;
+
+    j["top"] = json::array();
+    for (size_t k = 0; k < n; ++k) {
+        const uint32_t i = order[k];
+        const auto& p = prof[i];
+        const logic::RuleNode* node = instrs[i].node;
+
+        json e{
+            {"index", i},
+            {"path", logicNodePath(program, i)},
+            {"condition", node->condition()},
+            {"visits", p.visits},
+            {"evals", p.evals},
+            {"trueCount", p.trueCount},
+            {"falseCount", p.falseCount},
+            {"totalNs", p.totalNs},
+            {"maxNs", p.maxNs},
+            {"meanNs", p.visits ? p.totalNs / p.visits : 0},
+            {"share", totalNs ? static_cast<double>(p.totalNs) / static_cast<double>(totalNs) : 0.0},
+            {"fires", p.fires},
+            {"overridden", p.overridden},
+            {"unchanged", p.unchanged}
+        };
+        if (!node->id().empty()) e["id"] = node->id();
+
+        j["top"].push_back(std::move(e));
+    }
+
+    return j;
+}
+
+// ------------------------------------------------------------
+// POST logic/profile
+// { "enabled": bool, "reset": bool, "top": n }, all optional.
+// Returns the report. Call under the logic tick lock.
+// ------------------------------------------------------------
+inline json logicProfileSetJson(logic::RuleEngine& engine, const json& body) {
+    if (body.contains("enabled")) engine.setProfiling(body.at("enabled").get<bool>());
+    if (body.value("reset", false)) engine.resetProfile();
+    return logicProfileJson(engine, body.value("top", kLogicProfileTop));
+}
+
+} // namespace api
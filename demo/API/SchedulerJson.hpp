@@ -0,0 +1,51 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include "../Scheduler/Scheduler.hpp"
+#include "HistogramJson.hpp"
+
+namespace api {
+
+using json = nlohmann::json;
+
+// ------------------------------------------------------------
+// GET scheduler/stats
+// Per task name: start lateness and run time in microseconds,
+// plus fires dropped by the periodic policy.
+// ------------------------------------------------------------
+inline json schedulerStatsJson(Scheduler& sch) {
+    json j;
+    j["tasks"] = json::array();
+
+    for (const auto& s : sch.taskStats()) {
+        j["tasks"].push_back(json{
+            {"name", s.name},
+            {"overruns", s.overruns},
+            {"lateUs", histogramSummaryToJson(s.lateUs)},
+            {"runUs", histogramSummaryToJson(s.runUs)}
+        });
+    }
+
+    j["running"] = json::array();
+    for (const auto& r : sch.listRunningDetailed()) {
+        j["running"].push_back(json{
+            {"id", r.id},
+            {"name", r.name},
+            {"worker", r.workerIndex},
+            {"lane", r.lane}
+        });
+    }
+
+    return j;
+}
+
+// ------------------------------------------------------------
+// POST scheduler/stats/reset
+// ------------------------------------------------------------
+inline json schedulerStatsResetJson(Scheduler& sch) {
+    sch.resetTaskStats();
+    return json{{"ok", true}};
+}
+
+} // namespace api
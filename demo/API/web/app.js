@@ -8,6 +8,12 @@ let timer = null;
 let currentPage = "dashboard";
 
 const historyMap = {};
+
+// Local copy of server state, kept current with ?since=<version> deltas
+const deltaState = {
+  getters:   { epoch: null, version: 0, data: {} },
+  executors: { epoch: null, version: 0, data: new Map() },   // id -> executor
+};
 const selectedGetters = new Set(["temp"]);
 const MAX_POINTS = 120;
 
@@ -149,6 +155,35 @@ function formatAnyData(data) {
   return `${data.type}:${String(data.value)}`;
 }
 
+// Fetches only what changed since the last call. A new epoch means the
+// server restarted: drop the local copy and read everything again.
+async function fetchDelta(path, st, apply) {
+  let d = await jget(`${path}?since=${st.version}`);
+
+  if (d?.epoch !== st.epoch) {
+    if (st.version !== 0) d = await jget(`${path}?since=0`);
+    st.epoch = d?.epoch;
+    st.data = (st.data instanceof Map) ? new Map() : {};
+  }
+
+  apply(st.data, d?.changed);
+  st.version = d?.version ?? 0;
+  return st.data;
+}
+
+async function fetchGettersDelta() {
+  return fetchDelta("/getters", deltaState.getters, (data, changed) => {
+    Object.assign(data, changed || {});
+  });
+}
+
+async function fetchExecutorsDelta() {
+  const m = await fetchDelta("/executors", deltaState.executors, (data, changed) => {
+    (changed || []).forEach(x => data.set(x.id, x));
+  });
+  return Array.from(m.values());
+}
+
 function historyPush(getterKey, value) {
   if (!historyMap[getterKey]) {
     historyMap[getterKey] = [];
@@ -639,7 +674,7 @@ function logicPill(text, cls = "muted") {
 function renderLogicAction(a) {
   return `
     <div class="small mono muted">
-      action → target:${a.target}, type:${a.valueType}, value:${a.value}, trigger:${a.trigger}, enabled:${a.enabled}
+      action → target:${a.target}, type:${a.valueType}, value:${a.value}, trigger:${a.trigger}, priority:${a.priority ?? 0}, enabled:${a.enabled}
     </div>
   `;
 }
@@ -773,8 +808,8 @@ async function reloadAll() {
       jget("/status"),
       jget("/schema/getters"),
       jget("/schema/executors"),
-      jget("/getters"),
-      jget("/executors"),
+      fetchGettersDelta(),
+      fetchExecutorsDelta(),
     ]);
 
     setDot(status?.status === "ok");
@@ -0,0 +1,305 @@
+// ------------------------------------------------------------
+// Condition dispatch microbenchmark
+//
+// Evaluates a mix of conditions (gt, in_range, lt_i64, mod_part,
+// is_true) over pre-generated operands four ways:
+//   legacy string   : the former ConditionContext::check() -
+//                     count() on three maps, fresh std::vector<T>,
+//                     virtual IConditionStrategy<T>::evaluate()
+//   string          : ConditionContext::check() now
+//   legacy compiled : strategy resolved once, operands copied into
+//                     a reused std::vector<T>, virtual call
+//   compiled        : CondRef from find(), operands in an inline
+//                     array, function pointer (RuleEngine path)
+// Prints ns per evaluation and heap allocations per evaluation.
+// Each legacy / new pair must count the same true results.
+//
+// build (from demo/):
+//   g++ -std=c++17 -O2 Bench/ConditionDispatch.cpp -o cond_bench
+// run:
+//   ./cond_bench [evaluations=2000000]
+// ------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../Logic/ConditionContext.hpp"
+
+namespace {
+
+std::atomic<uint64_t> gAllocs{0};
+
+} // namespace
+
+// counts every heap allocation; out of line so the malloc/free
+// pairing stays hidden from the optimizer
+__attribute__((noinline)) void* operator new(std::size_t n) {
+    gAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using logic::ConditionContext;
+using logic::CondRef;
+using logic::CondType;
+
+// ------------------------------------------------------------
+// The dispatch as it was before function pointers
+// ------------------------------------------------------------
+template<typename T>
+struct LegacyStrategy {
+    virtual ~LegacyStrategy() = default;
+    virtual bool evaluate(const std::vector<T>& args) const = 0;
+};
+
+template<typename T, typename S>
+struct LegacyAdapter final : LegacyStrategy<T> {
+    bool evaluate(const std::vector<T>& args) const override {
+        if constexpr (std::is_same_v<T, bool>) {
+            bool a[logic::kMaxCondArgs]{};
+            for (size_t i = 0; i < args.size() && i < logic::kMaxCondArgs; ++i) a[i] = args[i];
+            return S::test(a, args.size());
+        } else {
+            return S::test(args.data(), args.size());
+        }
+    }
+};
+
+class LegacyContext {
+public:
+    LegacyContext() {
+        add<double, logic::CondGreater<double>>("gt");
+        add<double, logic::CondInRange<double>>("in_range");
+        add<long long, logic::CondLess<long long>>("lt_i64");
+        add<long long, logic::CondModPart<long long>>("mod_part");
+        boolMap_["is_true"] = std::make_unique<LegacyAdapter<bool, logic::CondEqual<bool>>>();
+    }
+
+    bool check(const std::string& key, const std::vector<std::string>& args) const {
+        if (boolMap_.count(key)) return checkTyped(boolMap_, key, args);
+        if (i64Map_.count(key))  return checkTyped(i64Map_, key, args);
+        if (f64Map_.count(key))  return checkTyped(f64Map_, key, args);
+        return false;
+    }
+
+    const LegacyStrategy<double>*    f64(const std::string& k) const { return f64Map_.at(k).get(); }
+    const LegacyStrategy<long long>* i64(const std::string& k) const { return i64Map_.at(k).get(); }
+    const LegacyStrategy<bool>*      b(const std::string& k) const { return boolMap_.at(k).get(); }
+
+private:
+    template<typename T>
+    using Map = std::unordered_map<std::string, std::unique_ptr<LegacyStrategy<T>>>;
+
+    Map<double>    f64Map_;
+    Map<long long> i64Map_;
+    Map<bool>      boolMap_;
+
+    template<typename T, typename S>
+    void add(const std::string& key) {
+        auto p = std::make_unique<LegacyAdapter<T, S>>();
+        if constexpr (std::is_same_v<T, double>) f64Map_[key] = std::move(p);
+        else                                     i64Map_[key] = std::move(p);
+    }
+
+    template<typename T>
+    static bool checkTyped(const Map<T>& mp, const std::string& key,
+                           const std::vector<std::string>& args) {
+        std::vector<T> converted;
+        for (const auto& s : args) {
+            T v{};
+            if (!ConditionContext::parseArg<T>(s, v)) return false;
+            converted.push_back(v);
+        }
+        if constexpr (std::is_same_v<T, bool>) {
+            if (key == "is_true") return converted.size() == 1 && converted[0];
+        }
+        return mp.at(key)->evaluate(converted);
+    }
+};
+
+// ------------------------------------------------------------
+// Workload
+// ------------------------------------------------------------
+struct Case {
+    std::string key;
+    CondType type{CondType::F64};
+    std::vector<std::string> text;
+    double    f64[logic::kMaxCondArgs]{};
+    long long i64[logic::kMaxCondArgs]{};
+    bool      b[logic::kMaxCondArgs]{};
+    size_t    n{0};
+};
+
+std::vector<Case> makeCases(size_t count) {
+    std::mt19937 rng(1234);
+    std::vector<Case> cases(count);
+
+    for (auto& c : cases) {
+        switch (rng() % 5) {
+            case 0:
+                c.key = "gt";
+                c.type = CondType::F64;
+                c.f64[0] = (rng() % 4000) / 100.0;
+                c.f64[1] = 20.0;
+                c.n = 2;
+                break;
+            case 1:
+                c.key = "in_range";
+                c.type = CondType::F64;
+                c.f64[0] = (rng() % 4000) / 100.0;
+                c.f64[1] = 18.5;
+                c.f64[2] = 24.0;
+                c.n = 3;
+                break;
+            case 2:
+                c.key = "lt_i64";
+                c.type = CondType::I64;
+                c.i64[0] = static_cast<long long>(rng() % 100000);
+                c.i64[1] = 50000;
+                c.n = 2;
+                break;
+            case 3:
+                c.key = "mod_part";
+                c.type = CondType::I64;
+                c.i64[0] = 1767225600000LL + static_cast<long long>(rng() % 1000000);
+                c.i64[1] = 50000;
+                c.i64[2] = 2;
+                c.i64[3] = 0;
+                c.n = 4;
+                break;
+            default:
+                c.key = "is_true";
+                c.type = CondType::BOOL;
+                c.b[0] = (rng() & 1) != 0;
+                c.n = 1;
+                break;
+        }
+
+        for (size_t i = 0; i < c.n; ++i) {
+            switch (c.type) {
+                case CondType::F64:  c.text.push_back(std::to_string(c.f64[i])); break;
+                case CondType::I64:  c.text.push_back(std::to_string(c.i64[i])); break;
+                case CondType::BOOL: c.text.push_back(c.b[i] ? "true" : "false"); break;
+            }
+        }
+    }
+    return cases;
+}
+
+struct Result {
+    double nsPerEval{0.0};
+    double allocsPerEval{0.0};
+    uint64_t trues{0};
+};
+
+template<typename Fn>
+Result run(size_t evals, size_t caseCount, Fn&& fn) {
+    Result r;
+    const uint64_t a0 = gAllocs.load();
+    const auto t0 = Clock::now();
+
+    for (size_t i = 0; i < evals; ++i) {
+        r.trues += fn(i % caseCount) ? 1 : 0;
+    }
+
+    const auto t1 = Clock::now();
+    r.nsPerEval = std::chrono::duration<double, std::nano>(t1 - t0).count() / evals;
+    r.allocsPerEval = static_cast<double>(gAllocs.load() - a0) / evals;
+    return r;
+}
+
+void print(const char* name, const Result& r) {
+    std::cout << "  " << name << ": " << r.nsPerEval << " ns/eval, "
+              << r.allocsPerEval << " allocs/eval, true=" << r.trues << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t evals = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+
+    const auto cases = makeCases(4096);
+    const LegacyContext legacy;
+    const ConditionContext ctx;
+
+    // resolved once, like RuleProgram::compile()
+    std::vector<CondRef> refs(cases.size());
+    std::vector<const void*> legacyRefs(cases.size());
+    for (size_t i = 0; i < cases.size(); ++i) {
+        ctx.find(cases[i].key, refs[i]);
+        switch (cases[i].type) {
+            case CondType::F64:  legacyRefs[i] = legacy.f64(cases[i].key); break;
+            case CondType::I64:  legacyRefs[i] = legacy.i64(cases[i].key); break;
+            case CondType::BOOL: legacyRefs[i] = legacy.b(cases[i].key);   break;
+        }
+    }
+
+    std::vector<double>    f64Args;
+    std::vector<long long> i64Args;
+    std::vector<bool>      boolArgs;
+
+    const auto legacyString = run(evals / 10, cases.size(), [&](size_t i) {
+        return legacy.check(cases[i].key, cases[i].text);
+    });
+
+    const auto string = run(evals / 10, cases.size(), [&](size_t i) {
+        return ctx.check(cases[i].key, cases[i].text);
+    });
+
+    const auto legacyCompiled = run(evals, cases.size(), [&](size_t i) {
+        const Case& c = cases[i];
+        switch (c.type) {
+            case CondType::F64:
+                f64Args.assign(c.f64, c.f64 + c.n);
+                return static_cast<const LegacyStrategy<double>*>(legacyRefs[i])->evaluate(f64Args);
+            case CondType::I64:
+                i64Args.assign(c.i64, c.i64 + c.n);
+                return static_cast<const LegacyStrategy<long long>*>(legacyRefs[i])->evaluate(i64Args);
+            case CondType::BOOL:
+                boolArgs.assign(c.b, c.b + c.n);
+                return boolArgs.size() == 1 && boolArgs[0];   // is_true special case
+        }
+        return false;
+    });
+
+    const auto compiled = run(evals, cases.size(), [&](size_t i) {
+        const Case& c = cases[i];
+        switch (c.type) {
+            case CondType::F64:  return ConditionContext::evaluate(refs[i], c.f64, c.n);
+            case CondType::I64:  return ConditionContext::evaluate(refs[i], c.i64, c.n);
+            case CondType::BOOL: return ConditionContext::evaluate(refs[i], c.b, c.n);
+        }
+        return false;
+    });
+
+    std::cout << "conditions: " << cases.size() << " cases, " << evals << " compiled evals ("
+              << evals / 10 << " string evals)\n";
+    print("legacy string  ", legacyString);
+    print("string         ", string);
+    print("legacy compiled", legacyCompiled);
+    print("compiled       ", compiled);
+
+    // every path sees the same cases in the same order
+    const bool agree = legacyString.trues == string.trues &&
+                       legacyCompiled.trues == compiled.trues;
+    if (!agree) {
+        std::cout << "MISMATCH between dispatch paths\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+// ------------------------------------------------------------
+// GH_GlobalState contention benchmark
+//
+// N reader threads poll the state the way HTTP / Logic do
+// (snapshot + handle reads), M writer threads update getters and
+// executor desired values the way DG / Logic do.
+// Prints reader throughput and writer latency (p50 / p99 / max).
+//
+// build (from demo/):
+//   g++ -std=c++17 -O2 -pthread Bench/GlobalStateContention.cpp -o gs_bench
+// run:
+//   ./gs_bench [readers=4] [writers=2] [seconds=3]
+// ------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../GlobalState.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kGetters = 32;
+constexpr int kExecs   = 16;
+
+uint64_t percentile(std::vector<uint64_t>& v, double p) {
+    if (v.empty()) return 0;
+    const size_t idx = static_cast<size_t>(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + idx, v.end());
+    return v[idx];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int readers = argc > 1 ? std::atoi(argv[1]) : 4;
+    const int writers = argc > 2 ? std::atoi(argv[2]) : 2;
+    const int seconds = argc > 3 ? std::atoi(argv[3]) : 3;
+
+    auto& gs = GH_GlobalState::instance();
+    using VT = GH_GlobalState::ValueType;
+    using Value = GH_GlobalState::Value;
+
+    std::vector<GH_GlobalState::GetterHandle> getters;
+    for (int i = 0; i < kGetters; ++i) {
+        getters.push_back(gs.registerGetter("bench.g" + std::to_string(i), VT::DOUBLE));
+        gs.setGetter(getters.back(), Value::of(0.0));
+    }
+
+    std::vector<GH_GlobalState::ExecHandle> execs;
+    for (int i = 0; i < kExecs; ++i) {
+        const std::string name = "bench.e" + std::to_string(i);
+        gs.setExecSchemaByName(name, VT::INT);
+        execs.push_back(gs.registerExecutor(name, 1000 + i));
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> readOps{0};
+    std::vector<std::vector<uint64_t>> writeLatNs(writers);
+
+    std::vector<std::thread> threads;
+
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            uint64_t ops = 0;
+            double sink = 0.0;
+            size_t i = static_cast<size_t>(r);
+
+            while (!stop.load(std::memory_order_relaxed)) {
+                // mostly point reads, sometimes a full table (HTTP poll)
+                if ((ops & 63) == 0) {
+                    auto snap = gs.execSnapshot();
+                    sink += static_cast<double>(snap->slots.size());
+                } else {
+                    auto e = gs.getGetterEntry(getters[i % getters.size()]);
+                    if (e.valid) sink += e.value.toDouble();
+                }
+                ++i;
+                ++ops;
+            }
+
+            readOps.fetch_add(ops);
+            if (sink < 0) std::cout << "";
+        });
+    }
+
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w] {
+            auto& lat = writeLatNs[w];
+            lat.reserve(1 << 20);
+            size_t i = static_cast<size_t>(w);
+
+            while (!stop.load(std::memory_order_relaxed)) {
+                const auto t0 = Clock::now();
+
+                if (i & 1) {
+                    gs.setGetter(getters[i % getters.size()], Value::of(static_cast<double>(i)));
+                } else {
+                    gs.setExecDesired(execs[i % execs.size()],
+                                      Value::of(static_cast<int>(i & 0xff)),
+                                      GH_MODE::AUTO, "bench");
+                }
+
+                const auto t1 = Clock::now();
+                if (lat.size() < lat.capacity())
+                    lat.push_back(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+                ++i;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    std::vector<uint64_t> all;
+    for (auto& v : writeLatNs) all.insert(all.end(), v.begin(), v.end());
+
+    const uint64_t writes = all.size();
+    const uint64_t mx = all.empty() ? 0 : *std::max_element(all.begin(), all.end());
+    const uint64_t p50 = percentile(all, 0.50);
+    const uint64_t p99 = percentile(all, 0.99);
+
+    std::cout << "readers=" << readers
+              << " writers=" << writers
+              << " seconds=" << seconds << "\n";
+    std::cout << "reads/s:  " << readOps.load() / static_cast<uint64_t>(seconds) << "\n";
+    std::cout << "writes/s: " << writes / static_cast<uint64_t>(seconds) << "\n";
+    std::cout << "write latency ns: p50=" << p50
+              << " p99=" << p99
+              << " max=" << mx << "\n";
+    return 0;
+}
@@ -0,0 +1,387 @@
+// ------------------------------------------------------------
+// Differential check of the rule engine
+//
+// Builds random rule trees (comparisons, time and modulo rules,
+// temporal conditions, expressions, dwell times, failing nodes,
+// actions of every trigger) and runs three engines on copies of
+// each tree, tick for tick on a virtual clock:
+//   reference   : setFullPass(true), every node every tick
+//   incremental : the normal tick (dirty marks, predicted edges)
+//   parallel    : the normal tick split into segments on 4 threads
+// Between ticks random getters are written and the clock moves
+// by a random step, often straight to the incremental engine's
+// nextWakeUnixMs(). After every tick each node's local / effective
+// result, error state and last fire time, and the commit counters,
+// must match the reference. The first mismatch is printed with its
+// tree and tick, and the exit code is 1.
+// Same seed -> same trees, steps and output.
+//
+// build (from demo/):
+//   g++ -std=c++17 -O2 -pthread Bench/RuleEngineDiff.cpp -o rule_diff
+// run:
+//   ./rule_diff [trees=200] [ticks=2000] [seed=1]
+// (compile errors of the deliberately broken rules go to stderr)
+// ------------------------------------------------------------
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../GlobalState.hpp"
+#include "../Tools/VirtualClock.hpp"
+#include "../Logic/RuleTree.hpp"
+#include "../Logic/RuleEngine.hpp"
+
+namespace {
+
+using logic::ActionModel;
+using logic::ActionValueType;
+using logic::RuleNode;
+using logic::TriggerMode;
+
+using Value = GH_GlobalState::Value;
+using VT = GH_GlobalState::ValueType;
+
+const char* const kDoubles[] = {"d0", "d1", "d2", "d3"};
+const char* const kInts[]    = {"i0", "i1"};
+const char* const kBools[]   = {"b0", "b1"};
+
+// E0..E3 bool, E4 / E5 int; "E_missing" is never registered
+constexpr int kBoolExecs = 4;
+constexpr int kIntExecs = 2;
+
+class Gen {
+public:
+    explicit Gen(uint64_t seed) : rng_(seed) {}
+
+    int pick(int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng_); }
+    bool chance(double p) { return std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < p; }
+    long long range(long long lo, long long hi) {
+        return std::uniform_int_distribution<long long>(lo, hi)(rng_);
+    }
+
+    template<size_t N>
+    const char* any(const char* const (&names)[N]) { return names[pick(static_cast<int>(N))]; }
+
+    std::string num(int lo, int hi) { return std::to_string(range(lo, hi)); }
+
+private:
+    std::mt19937_64 rng_;
+};
+
+// ------------------------------------------------------------
+// Random tree
+// ------------------------------------------------------------
+void randomCondition(Gen& g, std::string& cond, std::vector<std::string>& args) {
+    static const char* const cmpF64[] = {"gt", "lt", "eq", "neq", "gte", "lte"};
+    static const char* const cmpI64[] = {"gt_i64", "lt_i64", "eq_i64", "neq_i64", "gte_i64", "lte_i64"};
+    static const char* const modI64[] = {"mod_lt", "mod_lte", "mod_gt", "mod_gte", "mod_eq", "mod_neq"};
+    static const char* const timeTokens[] = {"time.second", "time.minute", "time.seconds_of_day",
+                                             "time.daily_hhmmss", "time.hour"};
+    static const char* const exprs[] = {
+        "d0 - d1 > 2",
+        "min(d0, d2) >= 3 && b0",
+        "abs(d1 - 4) < 2 || i0 == 3",
+        "time.second % 10 < 5",
+        "(time.seconds_of_day / 60) % 3 == 1 && !b1",
+        "d3 * 2 + i1 > 9",
+        "time.unix_ms % 7000 < 2500",
+    };
+
+    switch (g.pick(12)) {
+        case 0:
+            cond = g.any(cmpF64);
+            args = {g.any(kDoubles), g.num(0, 8)};
+            break;
+        case 1:
+            cond = g.chance(0.5) ? "in_range" : "out_of_range";
+            args = {g.any(kDoubles), g.num(0, 3), g.num(3, 8)};
+            break;
+        case 2:
+            cond = g.any(cmpI64);
+            if (g.chance(0.5)) args = {g.any(kInts), g.num(0, 5)};
+            else               args = {g.any(timeTokens), g.num(0, 59)};
+            break;
+        case 3:
+            cond = g.any(modI64);
+            args = {g.chance(0.5) ? "time.unix_ms" : "time.seconds_of_day", g.num(2, 20), g.num(0, 10)};
+            if (g.chance(0.5)) args[1] = std::to_string(std::stoll(args[1]) * 1000);
+            break;
+        case 4:
+            cond = "mod_part";
+            args = {g.chance(0.7) ? "time.unix_ms" : g.any(kInts), g.num(1, 3000), g.num(1, 4), g.num(0, 3)};
+            break;
+        case 5:
+            cond = g.chance(0.5) ? "is_true" : "is_false";
+            args = {g.any(kBools)};
+            break;
+        case 6:
+            cond = "in_range_for";
+            args = {g.any(kDoubles), g.num(0, 3), g.num(3, 8), g.num(0, 5000)};
+            break;
+        case 7:
+            cond = g.chance(0.5) ? "hysteresis" : "hysteresis_low";
+            args = {g.any(kDoubles), g.num(1, 3), g.num(4, 7)};
+            break;
+        case 8:
+            cond = g.chance(0.5) ? "rising" : "falling";
+            args = {g.any(kDoubles)};
+            break;
+        case 9:
+            cond = g.chance(0.5) ? "delta_gt" : "delta_lt";
+            args = {g.any(kDoubles), g.num(-1, 1)};
+            if (g.chance(0.5)) args.push_back(g.num(500, 20000));
+            break;
+        case 10:
+            cond = "expr";
+            args = {exprs[g.pick(static_cast<int>(sizeof(exprs) / sizeof(exprs[0])))]};
+            break;
+        default:
+            // constants and failing nodes
+            switch (g.pick(5)) {
+                case 0:  cond = "always";  args = {"0"}; break;
+                case 1:  cond = "never";   args = {"0"}; break;
+                case 2:  cond = "no_such_condition"; args = {"d0"}; break;
+                case 3:  cond = "gt";      args = {"missing_getter", "1"}; break;
+                default: cond = "expr";    args = {"d0 >"}; break;
+            }
+            break;
+    }
+}
+
+ActionModel randomAction(Gen& g) {
+    static const TriggerMode triggers[] = {TriggerMode::ON_ENTER, TriggerMode::ON_EXIT,
+                                           TriggerMode::WHILE_TRUE, TriggerMode::WHILE_FALSE};
+    ActionModel a;
+    a.trigger = triggers[g.pick(4)];
+    a.priority = g.pick(4);
+
+    if (g.chance(0.03)) {
+        a.target = "E_missing";
+        a.valueType = ActionValueType::BOOL;
+        a.value = "true";
+    } else if (g.chance(0.7)) {
+        a.target = "E" + std::to_string(g.pick(kBoolExecs));
+        a.valueType = ActionValueType::BOOL;
+        a.value = g.chance(0.5) ? "true" : "false";
+    } else {
+        a.target = "E" + std::to_string(kBoolExecs + g.pick(kIntExecs));
+        a.valueType = ActionValueType::INT;
+        a.value = g.num(0, 255);
+    }
+    return a;
+}
+
+RuleNode::Ptr randomNode(Gen& g, int depth, int& budget) {
+    std::string cond;
+    std::vector<std::string> args;
+    randomCondition(g, cond, args);
+
+    std::vector<ActionModel> actions;
+    const int actionCount = g.pick(3);
+    for (int k = 0; k < actionCount; ++k) actions.push_back(randomAction(g));
+
+    auto node = std::make_unique<RuleNode>("n" + std::to_string(budget), cond, args, actions);
+    if (g.chance(0.25)) {
+        const long long minOn = g.chance(0.5) ? 0 : g.range(1, 4000);
+        const long long minOff = g.chance(0.5) ? 0 : g.range(1, 4000);
+        node->setDwell(minOn, minOff);
+    }
+    --budget;
+
+    if (depth < 6) {
+        const int children = g.pick(depth == 0 ? 12 : 5);
+        for (int k = 0; k < children && budget > 0; ++k) {
+            node->addChild(randomNode(g, depth + 1, budget));
+        }
+    }
+    return node;
+}
+
+// three copies of one tree: the same seed builds the same nodes
+RuleNode::Ptr buildTree(uint64_t seed, int maxNodes) {
+    Gen g(seed);
+    int budget = maxNodes;
+
+    // the root is always true, as in logic.json
+    auto root = std::make_unique<RuleNode>("root", "always", std::vector<std::string>{"0"});
+    while (budget > 0 && root->children().size() < 16) {
+        root->addChild(randomNode(g, 1, budget));
+        if (g.chance(0.2)) break;
+    }
+    return root;
+}
+
+void preorder(RuleNode* n, std::vector<RuleNode*>& out) {
+    out.push_back(n);
+    for (auto& ch : n->children()) preorder(ch.get(), out);
+}
+
+struct Run {
+    logic::RuleTree tree;
+    std::unique_ptr<logic::RuleEngine> engine;
+    std::vector<RuleNode*> nodes;
+
+    Run(GH_GlobalState& gs, uint64_t seed, int maxNodes) {
+        tree.setRoot(buildTree(seed, maxNodes));
+        preorder(tree.root(), nodes);
+        engine = std::make_unique<logic::RuleEngine>(gs, tree);
+    }
+};
+
+bool sameCommit(const logic::RuleEngine::CommitStats& a, const logic::RuleEngine::CommitStats& b) {
+    return a.fired == b.fired && a.overridden == b.overridden && a.staged == b.staged;
+}
+
+// empty when equal
+std::string diff(const Run& ref, const Run& other) {
+    if (!sameCommit(ref.engine->lastCommit(), other.engine->lastCommit())) {
+        const auto& a = ref.engine->lastCommit();
+        const auto& b = other.engine->lastCommit();
+        return "commit fired/overridden/staged " +
+               std::to_string(a.fired) + "/" + std::to_string(a.overridden) + "/" + std::to_string(a.staged) +
+               " vs " +
+               std::to_string(b.fired) + "/" + std::to_string(b.overridden) + "/" + std::to_string(b.staged);
+    }
+
+    for (size_t i = 0; i < ref.nodes.size(); ++i) {
+        const auto& a = ref.nodes[i]->runtime();
+        const auto& b = other.nodes[i]->runtime();
+
+        std::string what;
+        if (a.localResult != b.localResult)               what = "localResult";
+        else if (a.effectiveResult != b.effectiveResult)  what = "effectiveResult";
+        else if (a.lastFireMs != b.lastFireMs)            what = "lastFireMs";
+        else if (a.lastError.empty() != b.lastError.empty()) what = "error state";
+        if (what.empty()) continue;
+
+        const RuleNode& n = *ref.nodes[i];
+        std::string args;
+        for (const auto& s : n.args()) args += (args.empty() ? "" : ", ") + s;
+        return "node " + std::to_string(i) + " " + n.condition() + "(" + args + ")" +
+               " dwell " + std::to_string(n.minOnMs()) + "/" + std::to_string(n.minOffMs()) +
+               ": " + what +
+               " ref local=" + std::to_string(a.localResult) + " eff=" + std::to_string(a.effectiveResult) +
+               " fire=" + std::to_string(a.lastFireMs) +
+               " | got local=" + std::to_string(b.localResult) + " eff=" + std::to_string(b.effectiveResult) +
+               " fire=" + std::to_string(b.lastFireMs);
+    }
+    return {};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int      trees = argc > 1 ? std::atoi(argv[1]) : 200;
+    const int      ticks = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const uint64_t seed  = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+
+    auto& clock = tools::VirtualClock::instance();
+    clock.enable(1767225600000LL);   // 2026-01-01 00:00 UTC
+    uint64_t elapsed = 0;
+
+    auto& gs = GH_GlobalState::instance();
+
+    std::vector<GH_GlobalState::GetterHandle> doubles, ints, bools;
+    for (const char* k : kDoubles) doubles.push_back(gs.registerGetter(k, VT::DOUBLE));
+    for (const char* k : kInts)    ints.push_back(gs.registerGetter(k, VT::INT));
+    for (const char* k : kBools)   bools.push_back(gs.registerGetter(k, VT::BOOL));
+
+    for (int i = 0; i < kBoolExecs + kIntExecs; ++i) {
+        const std::string name = "E" + std::to_string(i);
+        gs.setExecSchemaByName(name, i < kBoolExecs ? VT::BOOL : VT::INT);
+        const auto h = gs.registerExecutor(name, i + 1);
+        gs.setExecDesiredMode(h, GH_MODE::AUTO, "diff", false);
+        gs.setExecActualMode(h, GH_MODE::AUTO);
+    }
+
+    Gen g(seed);
+    auto writeGetters = [&](double p) {
+        for (const auto h : doubles) if (g.chance(p)) gs.setGetter(h, Value::of(static_cast<double>(g.range(0, 8))));
+        for (const auto h : ints)    if (g.chance(p)) gs.setGetter(h, Value::of(static_cast<int>(g.range(0, 5))));
+        for (const auto h : bools)   if (g.chance(p)) gs.setGetter(h, Value::of(g.chance(0.5)));
+    };
+    writeGetters(1.0);
+
+    long long nodes = 0, evaluated = 0, fired = 0, wakeSteps = 0;
+
+    for (int t = 0; t < trees; ++t) {
+        const uint64_t treeSeed = seed * 1000003ULL + static_cast<uint64_t>(t);
+        const int maxNodes = static_cast<int>(1 + g.range(0, t % 4 == 0 ? 1500 : 200));
+
+        Run ref(gs, treeSeed, maxNodes);
+        Run inc(gs, treeSeed, maxNodes);
+        Run par(gs, treeSeed, maxNodes);
+        ref.engine->setFullPass(true);
+        par.engine->setParallel(4, 1);
+        nodes += static_cast<long long>(ref.nodes.size());
+
+        for (int k = 0; k < ticks; ++k) {
+            if (k > 0) {
+                writeGetters(g.chance(0.3) ? 0.2 : 0.0);
+
+                // mostly control-loop steps, often exactly onto the
+                // predicted edge, sometimes the same instant or hours
+                const long long now = clock.unixMs();
+                const long long wake = inc.engine->nextWakeUnixMs();
+                long long step = 100;
+                switch (g.pick(20)) {
+                    case 0: case 1: case 2: case 3: case 4: case 5:
+                        step = g.range(1, 999);
+                        break;
+                    case 6: case 7: case 8: case 9:
+                        if (wake != LLONG_MAX && wake > now && wake - now < 86400000LL) {
+                            step = wake - now;
+                            ++wakeSteps;
+                        }
+                        break;
+                    case 10: case 11:
+                        step = g.range(1000, 60000);
+                        break;
+                    case 12:
+                        step = 0;
+                        break;
+                    case 13:
+                        step = g.range(60000, 6 * 3600000LL);
+                        break;
+                    default:
+                        break;
+                }
+                elapsed += static_cast<uint64_t>(step);
+                clock.advanceTo(elapsed);
+            }
+
+            if (g.chance(0.01)) {
+                ref.engine->requestRefresh();
+                inc.engine->requestRefresh();
+                par.engine->requestRefresh();
+            }
+
+            ref.engine->tick();
+            inc.engine->tick();
+            par.engine->tick();
+            fired += ref.engine->lastCommit().fired;
+            evaluated += static_cast<long long>(ref.nodes.size());
+
+            for (const Run* other : {&inc, &par}) {
+                const std::string d = diff(ref, *other);
+                if (d.empty()) continue;
+
+                std::cout << "MISMATCH " << (other == &inc ? "incremental" : "parallel")
+                          << " tree=" << t << " (seed " << treeSeed << ", " << maxNodes << " nodes max)"
+                          << " tick=" << k << " at " << tools::unixMsToString(clock.unixMs()) << "\n"
+                          << "  " << d << "\n";
+                return 1;
+            }
+        }
+    }
+
+    std::cout << "OK trees=" << trees << " ticks/tree=" << ticks
+              << " nodes=" << nodes << " node-ticks=" << evaluated
+              << " fired=" << fired << " edge steps=" << wakeSteps << "\n";
+    return 0;
+}
@@ -0,0 +1,171 @@
+// ------------------------------------------------------------
+// Fast-forward simulation of the control loop
+//
+// Runs the time getter (1 s, like DG_TIME) and the logic tick
+// (100 ms) from logic.json on the Scheduler with a virtual clock,
+// for the given number of simulated days starting at a fixed
+// instant. Like main.cpp, the logic tick is also triggered at the
+// next edge predicted by time-driven rules. Counts every
+// desired-state change per executor, so a mod_part blink or a
+// daily schedule can be checked without waiting for it.
+// Same inputs -> same output.
+//
+// build (from demo/):
+//   g++ -std=c++17 -O2 -pthread -I<nlohmann include> Bench/VirtualClockSim.cpp -o sim_bench
+// run:
+//   ./sim_bench [days=7] [logic=logic.json] [startUnixMs=1767225600000]
+// ------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "../GlobalState.hpp"
+#include "../Scheduler/Scheduler.hpp"
+#include "../Logic/RuleTree.hpp"
+#include "../Logic/RuleEngine.hpp"
+#include "../Logic/LogicJsonController.hpp"
+
+namespace {
+
+constexpr int kDcmDigital = 8;
+
+struct ExecTrace {
+    long long changes{0};
+    long long lastChangeMs{0};
+    std::string last;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const double      days    = argc > 1 ? std::atof(argv[1]) : 7.0;
+    const std::string file    = argc > 2 ? argv[2] : "logic.json";
+    const long long   startMs = argc > 3 ? std::atoll(argv[3]) : 1767225600000LL;   // 2026-01-01 00:00 UTC
+
+    // one worker: runs due at the same tick keep their order
+    auto& sch = Scheduler::instance(1);
+    sch.useVirtualClock(startMs);
+
+    auto& gs = GH_GlobalState::instance();
+    using VT = GH_GlobalState::ValueType;
+    using Value = GH_GlobalState::Value;
+
+    const auto timeGetter = gs.registerGetter("time", VT::TIME);
+    for (int i = 0; i < kDcmDigital; ++i) {
+        const std::string name = "LOW_DCM_D_" + std::to_string(i);
+        gs.setExecSchemaByName(name, VT::BOOL);
+        const auto h = gs.registerExecutor(name, i + 1);
+        gs.setExecDesiredMode(h, GH_MODE::AUTO, "sim", false);
+        gs.setExecActualMode(h, GH_MODE::AUTO);
+    }
+
+    // observer runs under the state writer lock, so no extra locking
+    std::map<std::string, ExecTrace> traces;
+    gs.setWriteObserver([&traces](const GH_GlobalState::StateWrite& w) {
+        if (w.kind != GH_GlobalState::StateWriteKind::EXEC_DESIRED || w.modeOnly) return;
+
+        auto& t = traces[w.name];
+        const auto& val = w.value;
+        const std::string v = !val.hasValue()              ? "-"
+                            : val.type == VT::BOOL         ? (val.num.b ? "true" : "false")
+                            : val.type == VT::STRING       ? val.str
+                            : std::to_string(val.toDouble());
+        if (v == t.last) return;
+        t.last = v;
+        ++t.changes;
+        t.lastChangeMs = tools::nowUnixMs();
+    });
+
+    logic::RuleTree tree;
+    logic::RuleEngine engine(gs, tree);
+    logic::LogicJsonController logicJson(tree, engine, file);
+    try {
+        logicJson.loadFromFile();
+    } catch (const std::exception& ex) {
+        std::cerr << "failed to load " << file << ": " << ex.what() << "\n";
+        // the scheduler's workers are already running; joining them
+        // here keeps static destruction from calling std::terminate()
+        sch.stop();
+        gs.setWriteObserver(nullptr);
+        return 1;
+    }
+
+    std::atomic<long long> logicTicks{0};
+    const Scheduler::PeriodicPolicy phaseLocked{Scheduler::Periodic::FIXED_RATE_SKIP, true};
+
+    gs.setGetter(timeGetter, Value::of(tools::UnixMs(tools::nowUnixMs())));
+    const auto timeTask = sch.addPeriodic([&]() {
+        gs.setGetter(timeGetter, Value::of(tools::UnixMs(tools::nowUnixMs())));
+    }, Scheduler::Ms(1000), "time", phaseLocked);
+
+    // one worker, so the wake state needs no lock
+    Scheduler::TaskId logicTask = 0;
+    long long wakeAt = LLONG_MIN;
+    Scheduler::TaskId wakeTask = 0;
+
+    logicTask = sch.addPeriodic([&]() {
+        engine.tick();
+        ++logicTicks;
+
+        const long long at = engine.nextWakeUnixMs();
+        const long long now = tools::nowUnixMs();
+        const bool pending = wakeAt > now;
+        if (at == LLONG_MAX || (pending && wakeAt <= at)) return;
+        if (pending) sch.cancel(wakeTask);
+
+        wakeAt = at;
+        wakeTask = sch.addDelayed([&]() {
+            sch.trigger(logicTask);
+        }, Scheduler::Ms(std::max(0LL, at - now)), "logic edge wake");
+    }, Scheduler::Ms(100), "logic", phaseLocked);
+
+    std::mutex doneMtx;
+    std::condition_variable doneCv;
+    bool done = false;
+    long long endMs = 0;
+
+    // with nothing left queued, simulated time stops right here.
+    // The clock already runs, so aim at startMs + simMs, not at now.
+    const auto simMs = static_cast<long long>(days * 86400000.0);
+    const long long endDelay = std::max(0LL, startMs + simMs - tools::nowUnixMs());
+    sch.addDelayed([&]() {
+        sch.cancel(timeTask);
+        sch.cancel(logicTask);
+        sch.cancel(wakeTask);
+
+        std::lock_guard<std::mutex> lk(doneMtx);
+        endMs = tools::nowUnixMs();
+        done = true;
+        doneCv.notify_all();
+    }, Scheduler::Ms(endDelay), "end");
+
+    const auto t0 = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lk(doneMtx);
+        doneCv.wait(lk, [&]{ return done; });
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    sch.stop();
+    gs.setWriteObserver(nullptr);
+
+    const double wall = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << "simulated: " << days << " days, "
+              << tools::unixMsToString(startMs) << " .. "
+              << tools::unixMsToString(endMs) << "\n";
+    std::cout << "wall:      " << wall << " s (x" << static_cast<long long>(simMs / 1000.0 / wall) << ")\n";
+    std::cout << "logic ticks: " << logicTicks.load() << "\n";
+    for (const auto& kv : traces) {
+        std::cout << "  " << kv.first
+                  << " changes=" << kv.second.changes
+                  << " last=" << kv.second.last
+                  << " at " << tools::unixMsToString(kv.second.lastChangeMs) << "\n";
+    }
+    return 0;
+}
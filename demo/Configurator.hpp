@@ -12,10 +12,12 @@
 #include <cctype>
 
 #include "GlobalState.hpp"
+#include "Tools/DateTime.hpp"
 
 class GH_Configurator {
 public:
     using ValueType  = GH_GlobalState::ValueType;
+    using Value      = GH_GlobalState::Value;
     using DcmBinding = GH_GlobalState::DcmBinding;
 
     struct GetterBinding {
@@ -128,8 +130,8 @@ private:
         const std::string valueStr = trim(parts[2]);
         const GH_MODE mode = parseMode(trim(parts[3]));
 
-        gs.registerExecNameToId(name, id);
-        gs.setExec(id, parseAny(vt, valueStr), mode);
+        const auto h = gs.registerExecutor(name, id);
+        gs.setExecActual(h, parseValue(vt, valueStr), mode, false);
     }
 
     void parseGetterLine(const std::string& line, GH_GlobalState& gs) {
@@ -149,7 +151,7 @@ private:
         const ValueType vt = parseValueType(parts[0]);
         const std::string valueStr = trim(joinRest(parts, 1, parts.size() - 1));
 
-        gs.setGetter(key, parseAny(vt, valueStr));
+        gs.setGetter(key, parseValue(vt, valueStr));
     }
 
     void parseDcmMapLine(const std::string& line, GH_GlobalState& gs) {
@@ -208,7 +210,8 @@ private:
         if (s == "int")    return ValueType::INT;
         if (s == "double") return ValueType::DOUBLE;
         if (s == "string") return ValueType::STRING;
-        throw std::runtime_error("Unsupported type (bool/int/double/string): " + s);
+        if (s == "time")   return ValueType::TIME;
+        throw std::runtime_error("Unsupported type (bool/int/double/string/time): " + s);
     }
 
     static std::string stripComment(const std::string& s) {
@@ -281,13 +284,22 @@ private:
         throw std::runtime_error("Invalid mode (manual/auto or 0/1): " + s);
     }
 
-    static std::any parseAny(ValueType t, const std::string& value) {
+    static long long parseInt64(std::string s) {
+        s = trim(s);
+        size_t idx = 0;
+        long long v = std::stoll(s, &idx, 10);
+        if (idx != s.size()) throw std::runtime_error("Invalid int64: " + s);
+        return v;
+    }
+
+    static Value parseValue(ValueType t, const std::string& value) {
         switch (t) {
-            case ValueType::BOOL:   return std::any(parseBool(value));
-            case ValueType::INT:    return std::any(parseInt(value));
-            case ValueType::DOUBLE: return std::any(parseDouble(value));
-            case ValueType::STRING: return std::any(value);
+            case ValueType::BOOL:   return Value::of(parseBool(value));
+            case ValueType::INT:    return Value::of(parseInt(value));
+            case ValueType::DOUBLE: return Value::of(parseDouble(value));
+            case ValueType::STRING: return Value::of(value);
+            case ValueType::TIME:   return Value::of(tools::UnixMs(parseInt64(value)));
         }
-        throw std::runtime_error("parseAny: unreachable");
+        throw std::runtime_error("parseValue: unreachable");
     }
 };
\ No newline at end of file
@@ -1,15 +1,36 @@
 #pragma once
 
+#include <algorithm>
 #include <any>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "../GlobalState.hpp"
 #include "Executor.hpp"
 #include "EX_DeviceControlModule.hpp"
 
+// ------------------------------------------------------------
+// Retry policy for applies that failed to queue: the wait starts
+// at GH_BRIDGE_RETRY_BASE_MS and doubles up to GH_BRIDGE_RETRY_MAX_MS;
+// after GH_BRIDGE_RETRY_ATTEMPTS failures of one desired revision
+// the bridge gives up on it until a new value is written.
+// ------------------------------------------------------------
+#ifndef GH_BRIDGE_RETRY_BASE_MS
+#define GH_BRIDGE_RETRY_BASE_MS 200
+#endif
+
+#ifndef GH_BRIDGE_RETRY_MAX_MS
+#define GH_BRIDGE_RETRY_MAX_MS 30000
+#endif
+
+#ifndef GH_BRIDGE_RETRY_ATTEMPTS
+#define GH_BRIDGE_RETRY_ATTEMPTS 8
+#endif
+
 namespace control {
 
 class ExecutorStateBridge {
@@ -17,27 +38,41 @@ public:
     ExecutorStateBridge(GH_GlobalState& gs, exec::Executor& executor)
         : gs_(gs), executor_(executor) {}
 
-    void applyMappedActualAndQueue(const std::string& execName,
-                                   const std::any& rawValue,
-                                   int priority = 10,
-                                   GH_MODE mode = GH_MODE::AUTO) {
+    using Value = GH_GlobalState::Value;
+    using ValueType = GH_GlobalState::ValueType;
+
+    // REJECTED: no binding or a value the binding cannot take, which
+    // no retry fixes. FAILED: mapped but could not be queued. Either
+    // way the error is already recorded on the executor's actual state.
+    enum class ApplyResult : uint8_t { APPLIED, REJECTED, FAILED };
+
+    ApplyResult applyMappedActualAndQueue(const std::string& execName,
+                                          const Value& rawValue,
+                                          int priority = 10,
+                                          GH_MODE mode = GH_MODE::AUTO) {
+        bool queueing = false;
         try {
             const auto bind = gs_.getDcmBindingByName(execName);
-            const int id = gs_.execIdByName(execName);
+            const auto id = gs_.execHandleByName(execName);
+
+            if (!rawValue.hasValue()) {
+                throw std::runtime_error("Empty desired value for " + execName);
+            }
 
             if (bind.tableId == DeviceControlModule::TABLE_DIGITAL) {
                 bool v = false;
 
-                if (rawValue.type() == typeid(bool)) {
-                    v = std::any_cast<bool>(rawValue);
-                } else if (rawValue.type() == typeid(int)) {
-                    v = (std::any_cast<int>(rawValue) != 0);
+                if (rawValue.type == ValueType::BOOL) {
+                    v = rawValue.num.b;
+                } else if (rawValue.type == ValueType::INT) {
+                    v = (rawValue.num.i != 0);
                 } else {
                     throw std::runtime_error(
                         "Digital binding expects bool/int for " + execName
                     );
                 }
 
+                queueing = true;
                 executor_.enqueue(
                     "DCM",
                     priority,
@@ -45,9 +80,10 @@ public:
                     bind.index,
                     v ? 1 : 0
                 );
+                queueing = false;
 
                 gs_.setExecPending(id, true);
-                gs_.setExecActual(id, v, mode, false);
+                gs_.setExecActual(id, Value::of(v), mode, false);
                 gs_.setExecPending(id, false);
                 gs_.clearExecApplyError(id);
 
@@ -56,16 +92,16 @@ public:
                           << " <= " << std::boolalpha << v
                           << " [" << bind.tableId << "," << bind.index
                           << "," << (v ? 1 : 0) << "]\n";
-                return;
+                return ApplyResult::APPLIED;
             }
 
             if (bind.tableId == DeviceControlModule::TABLE_PWM) {
                 int pwm = 0;
 
-                if (rawValue.type() == typeid(int)) {
-                    pwm = std::any_cast<int>(rawValue);
-                } else if (rawValue.type() == typeid(bool)) {
-                    pwm = std::any_cast<bool>(rawValue) ? 255 : 0;
+                if (rawValue.type == ValueType::INT) {
+                    pwm = rawValue.num.i;
+                } else if (rawValue.type == ValueType::BOOL) {
+                    pwm = rawValue.num.b ? 255 : 0;
                 } else {
                     throw std::runtime_error(
                         "PWM binding expects int/bool for " + execName
@@ -78,6 +114,7 @@ public:
                     );
                 }
 
+                queueing = true;
                 executor_.enqueue(
                     "DCM",
                     priority,
@@ -85,9 +122,10 @@ public:
                     bind.index,
                     pwm
                 );
+                queueing = false;
 
                 gs_.setExecPending(id, true);
-                gs_.setExecActual(id, pwm, mode, false);
+                gs_.setExecActual(id, Value::of(pwm), mode, false);
                 gs_.setExecPending(id, false);
                 gs_.clearExecApplyError(id);
 
@@ -96,7 +134,7 @@ public:
                           << " <= " << pwm
                           << " [" << bind.tableId << "," << bind.index
                           << "," << pwm << "]\n";
-                return;
+                return ApplyResult::APPLIED;
             }
 
             throw std::runtime_error(
@@ -107,25 +145,73 @@ public:
                       << ": " << ex.what() << "\n";
 
             try {
-                const int id = gs_.execIdByName(execName);
+                const auto id = gs_.execHandleByName(execName);
                 gs_.setExecApplyError(id, ex.what());
                 gs_.setExecActualInvalid(id, ex.what());
             } catch (...) {
             }
         }
+        return queueing ? ApplyResult::FAILED : ApplyResult::REJECTED;
     }
 
+    // Applies only executors reported by the GlobalState dirty feed.
+    // Called from the control cycle's bridge stage; ticks are
+    // serialized in case another caller is added.
     void tick() {
+        std::lock_guard<std::mutex> lk(tickMtx_);
+
         try {
-            auto execs = gs_.snapshotExecutors();
+            const uint64_t now = GH_GlobalState::nowMs();
+
+            work_.clear();
+            gs_.drainDirtyExecs(work_);
+
+            // failed applies whose backoff has ended; the rest wait
+            std::sort(retry_.begin(), retry_.end(),
+                      [](auto a, auto b) { return a.slot < b.slot; });
+            retry_.erase(std::unique(retry_.begin(), retry_.end(),
+                                     [](auto a, auto b) { return a.slot == b.slot; }),
+                         retry_.end());
+            waiting_.clear();
+            for (const auto id : retry_) {
+                (retryDue(id, now) ? work_ : waiting_).push_back(id);
+            }
+            retry_.swap(waiting_);
+
+            if (work_.empty()) {
+                return;
+            }
+
+            std::sort(work_.begin(), work_.end(),
+                      [](auto a, auto b) { return a.slot < b.slot; });
+            work_.erase(std::unique(work_.begin(), work_.end(),
+                                    [](auto a, auto b) { return a.slot == b.slot; }),
+                        work_.end());
+
+            // taken after the drain, so it contains every drained write
+            const auto snap = gs_.execSnapshot();
+
+            for (const auto id : work_) {
+                if (id.slot >= snap->slots.size()) {
+                    continue;
+                }
+
+                const auto& rec = *snap->slots[id.slot];
+                const auto& e = rec.state;
 
-            for (const auto& e : execs) {
                 if (!e.desired.dirty) {
                     continue;
                 }
 
-                const std::string& execName = e.name;
-                const int id = e.id;
+                const std::string& execName = rec.name;
+
+                // a new desired value starts over; the old one may still
+                // be backing off (it is kept in retry_ meanwhile)
+                RetryState& rs = retryState(id);
+                if (rs.attempts > 0 && rs.rev != e.desired.rev) rs = RetryState{};
+                if (rs.attempts > 0 && now < rs.dueMs) {
+                    continue;
+                }
 
                 try {
                     // 1. mode sync
@@ -136,47 +222,37 @@ public:
                     // 2. desired invalid
                     if (!e.desired.valid) {
                         gs_.setExecActualInvalid(id, "desired invalid");
-                        gs_.markExecDirty(id, false);
+                        gs_.clearExecDirty(id, e.desired.rev);
                         continue;
                     }
 
                     // 3. dedup actual vs desired
-                    bool sameType = (e.actual.value.type() == e.desired.value.type());
-                    bool sameValue = false;
-
-                    if (sameType) {
-                        if (e.desired.value.type() == typeid(bool)) {
-                            sameValue =
-                                std::any_cast<bool>(e.actual.value) ==
-                                std::any_cast<bool>(e.desired.value);
-                        } else if (e.desired.value.type() == typeid(int)) {
-                            sameValue =
-                                std::any_cast<int>(e.actual.value) ==
-                                std::any_cast<int>(e.desired.value);
-                        } else if (e.desired.value.type() == typeid(double)) {
-                            sameValue =
-                                std::any_cast<double>(e.actual.value) ==
-                                std::any_cast<double>(e.desired.value);
-                        }
-                    }
-
                     if (e.actual.valid &&
-                        sameType &&
-                        sameValue &&
+                        e.actual.value == e.desired.value &&
                         e.actual.mode == e.desired.mode) {
-                        gs_.markExecDirty(id, false);
+                        gs_.clearExecDirty(id, e.desired.rev);
                         continue;
                     }
 
-                    // 4. apply
-                    applyMappedActualAndQueue(execName, e.desired.value, 10, e.desired.mode);
+                    // 4. apply; only a failure to queue is retried
+                    const auto result = applyMappedActualAndQueue(execName, e.desired.value,
+                                                                  10, e.desired.mode);
+                    if (result == ApplyResult::FAILED) {
+                        retryLater(id, execName, e.desired.rev, now);
+                        continue;
+                    }
 
-                    // 5. clear dirty after success
-                    gs_.markExecDirty(id, false);
+                    // 5. clear dirty after success or a rejected value, unless
+                    //    a newer desired value arrived meanwhile (its bit is
+                    //    already set)
+                    rs = RetryState{};
+                    gs_.clearExecDirty(id, e.desired.rev);
                 } catch (const std::exception& ex) {
                     gs_.setExecApplyError(id, ex.what());
+                    retryLater(id, execName, e.desired.rev, now);
                 } catch (...) {
                     gs_.setExecApplyError(id, "unknown bridge error");
+                    retryLater(id, execName, e.desired.rev, now);
                 }
             }
         } catch (const std::exception& ex) {
@@ -187,8 +263,50 @@ public:
     }
 
 private:
+    using ExecHandle = GH_GlobalState::ExecHandle;
+
+    // backoff of one exec slot's current desired revision
+    struct RetryState {
+        uint32_t attempts{0};   // 0 = not retrying
+        uint64_t rev{0};
+        uint64_t dueMs{0};
+    };
+
+    RetryState& retryState(ExecHandle id) {
+        if (id.slot >= retryState_.size()) retryState_.resize(id.slot + 1);
+        return retryState_[id.slot];
+    }
+
+    bool retryDue(ExecHandle id, uint64_t now) {
+        return now >= retryState(id).dueMs;
+    }
+
+    void retryLater(ExecHandle id, const std::string& execName, uint64_t rev, uint64_t now) {
+        RetryState& rs = retryState(id);
+        if (rs.rev != rev) rs = RetryState{0, rev, 0};
+
+        if (++rs.attempts >= GH_BRIDGE_RETRY_ATTEMPTS) {
+            std::cout << "[BRIDGE] giving up on " << execName
+                      << " after " << rs.attempts << " attempts\n";
+            rs = RetryState{};
+            gs_.clearExecDirty(id, rev);
+            return;
+        }
+
+        const uint64_t wait = std::min<uint64_t>(
+            uint64_t{GH_BRIDGE_RETRY_BASE_MS} << (rs.attempts - 1), GH_BRIDGE_RETRY_MAX_MS);
+        rs.dueMs = now + wait;
+        retry_.push_back(id);
+    }
+
     GH_GlobalState& gs_;
     exec::Executor& executor_;
+
+    std::mutex tickMtx_;
+    std::vector<ExecHandle> work_;
+    std::vector<ExecHandle> retry_;     // failed to queue, waiting for their backoff
+    std::vector<ExecHandle> waiting_;   // scratch for the retry_ split
+    std::vector<RetryState> retryState_;   // by exec slot
 };
 
 } // namespace control
\ No newline at end of file
@@ -1,15 +1,30 @@
 #pragma once
 
+#include <algorithm>
 #include <any>
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include <mutex>
 #include <shared_mutex>
 #include <chrono>
+#include <functional>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 
+#include "Tools/DateTime.hpp"
+#include "Tools/HistoryRing.hpp"
+
+// capacity of the executor dirty bitset
+#ifndef GH_MAX_EXEC_SLOTS
+#define GH_MAX_EXEC_SLOTS 256
+#endif
+
 enum class GH_MODE : uint8_t { MANUAL = 0, AUTO = 1 };
 
 inline std::string toString(GH_MODE m) {
@@ -25,14 +40,144 @@ public:
         BOOL,
         INT,
         DOUBLE,
-        STRING
+        STRING,
+        TIME
+    };
+
+    // ------------------------------------------------------------
+    // Typed value: tagged union over ValueType.
+    // Numeric kinds live in the union, only STRING touches str.
+    // ------------------------------------------------------------
+    struct Value {
+        union Scalar {
+            bool      b;
+            int       i;
+            double    d;
+            long long ms;
+        };
+
+        ValueType   type{ValueType::BOOL};
+        bool        set{false};
+        Scalar      num{};
+        std::string str;
+
+        static Value of(bool v)          { Value x; x.type = ValueType::BOOL;   x.set = true; x.num.b = v;  return x; }
+        static Value of(int v)           { Value x; x.type = ValueType::INT;    x.set = true; x.num.i = v;  return x; }
+        static Value of(double v)        { Value x; x.type = ValueType::DOUBLE; x.set = true; x.num.d = v;  return x; }
+        static Value of(std::string v)   { Value x; x.type = ValueType::STRING; x.set = true; x.str = std::move(v); return x; }
+        static Value of(const char* v)   { return of(std::string(v ? v : "")); }
+        static Value of(tools::UnixMs v) { Value x; x.type = ValueType::TIME;   x.set = true; x.num.ms = v.value; return x; }
+
+        bool hasValue() const { return set; }
+
+        bool isNumeric() const {
+            return set && type != ValueType::STRING;
+        }
+
+        // numeric view used by comparisons and aggregation
+        double toDouble() const {
+            switch (type) {
+                case ValueType::BOOL:   return num.b ? 1.0 : 0.0;
+                case ValueType::INT:    return static_cast<double>(num.i);
+                case ValueType::DOUBLE: return num.d;
+                case ValueType::TIME:   return static_cast<double>(num.ms);
+                case ValueType::STRING: break;
+            }
+            throw std::runtime_error("Value is not numeric");
+        }
+
+        template<class T>
+        T get() const {
+            if (!set) throw std::runtime_error("Value is empty");
+
+            if constexpr (std::is_same_v<T, bool>) {
+                if (type == ValueType::BOOL) return num.b;
+            } else if constexpr (std::is_same_v<T, int>) {
+                if (type == ValueType::INT) return num.i;
+            } else if constexpr (std::is_same_v<T, double>) {
+                if (type == ValueType::DOUBLE) return num.d;
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                if (type == ValueType::STRING) return str;
+            } else if constexpr (std::is_same_v<T, tools::UnixMs>) {
+                if (type == ValueType::TIME) return tools::UnixMs(num.ms);
+            } else {
+                static_assert(!sizeof(T), "Unsupported Value::get<T>");
+            }
+
+            throw std::runtime_error("Value type mismatch");
+        }
+
+        static Value fromAny(const std::any& a) {
+            if (!a.has_value()) return Value{};
+
+            const auto& t = a.type();
+            if (t == typeid(Value))         return std::any_cast<const Value&>(a);
+            if (t == typeid(bool))          return of(std::any_cast<bool>(a));
+            if (t == typeid(int))           return of(std::any_cast<int>(a));
+            if (t == typeid(double))        return of(std::any_cast<double>(a));
+            if (t == typeid(float))         return of(static_cast<double>(std::any_cast<float>(a)));
+            if (t == typeid(std::string))   return of(std::any_cast<const std::string&>(a));
+            if (t == typeid(const char*))   return of(std::any_cast<const char*>(a));
+            if (t == typeid(tools::UnixMs)) return of(std::any_cast<tools::UnixMs>(a));
+
+            throw std::runtime_error("Unsupported value type for GlobalState");
+        }
+
+        std::any toAny() const {
+            if (!set) return {};
+            switch (type) {
+                case ValueType::BOOL:   return num.b;
+                case ValueType::INT:    return num.i;
+                case ValueType::DOUBLE: return num.d;
+                case ValueType::STRING: return str;
+                case ValueType::TIME:   return tools::UnixMs(num.ms);
+            }
+            return {};
+        }
+
+        bool operator==(const Value& o) const {
+            if (set != o.set) return false;
+            if (!set) return true;
+            if (type != o.type) return false;
+
+            switch (type) {
+                case ValueType::BOOL:   return num.b == o.num.b;
+                case ValueType::INT:    return num.i == o.num.i;
+                case ValueType::DOUBLE: return num.d == o.num.d;
+                case ValueType::STRING: return str == o.str;
+                case ValueType::TIME:   return num.ms == o.num.ms;
+            }
+            return false;
+        }
+
+        bool operator!=(const Value& o) const { return !(*this == o); }
+    };
+
+    // ------------------------------------------------------------
+    // Dense slot handles, handed out at registration.
+    // Hot paths resolve a name once and then index slots directly.
+    // ------------------------------------------------------------
+    static constexpr uint32_t kNoSlot = 0xFFFFFFFFu;
+
+    struct GetterHandle {
+        uint32_t slot{kNoSlot};
+        bool valid() const { return slot != kNoSlot; }
+        bool operator==(const GetterHandle& o) const { return slot == o.slot; }
+        bool operator!=(const GetterHandle& o) const { return slot != o.slot; }
+    };
+
+    struct ExecHandle {
+        uint32_t slot{kNoSlot};
+        bool valid() const { return slot != kNoSlot; }
+        bool operator==(const ExecHandle& o) const { return slot == o.slot; }
+        bool operator!=(const ExecHandle& o) const { return slot != o.slot; }
     };
 
     // ------------------------------------------------------------
     // Getter entry
     // ------------------------------------------------------------
     struct GetterEntry {
-        std::any value;
+        Value value;
         bool valid{false};
         uint64_t stampMs{0};
     };
@@ -41,23 +186,24 @@ public:
     // Executor entries
     // ------------------------------------------------------------
     struct ExecEntry {
-        std::any value;
+        Value value;
         GH_MODE mode{GH_MODE::MANUAL};
         bool valid{true};
         uint64_t stampMs{0};
     };
 
     struct ExecDesiredEntry {
-        std::any value;
+        Value value;
         GH_MODE mode{GH_MODE::MANUAL};
         bool valid{false};
         bool dirty{false};
         std::string lastWriter{"unknown"};
         uint64_t stampMs{0};
+        uint64_t rev{0};               // bumped by every write that marks dirty
     };
 
     struct ExecActualEntry {
-        std::any value;
+        Value value;
         GH_MODE mode{GH_MODE::MANUAL};
         bool valid{false};
         bool pending{false};
@@ -80,6 +226,49 @@ public:
         ValueType type{ValueType::BOOL};
     };
 
+    // ------------------------------------------------------------
+    // Published slot records (immutable once published)
+    // ------------------------------------------------------------
+    struct GetterRecord {
+        std::string key;
+        ValueType type{ValueType::DOUBLE};
+        GetterEntry entry;
+        uint64_t version{0};           // global state version of the last write
+    };
+
+    struct ExecRecord {
+        int id{0};
+        std::string name;
+        ValueType type{ValueType::BOOL};
+        ExecFullEntry state;
+        uint64_t version{0};           // global state version of the last write
+    };
+
+    // ------------------------------------------------------------
+    // Versioned snapshot of a slot table.
+    // Writers copy the touched record, stamp it with the next global
+    // state version and swap the table pointer; readers only load the
+    // pointer, so they never hold a lock that a writer has to wait for.
+    // version is the stamp of the newest record in the table.
+    // ------------------------------------------------------------
+    template<class R>
+    struct Snapshot {
+        uint64_t version{0};
+        std::vector<std::shared_ptr<const R>> slots;
+    };
+
+    using GetterSnapshot    = Snapshot<GetterRecord>;
+    using ExecSnapshot      = Snapshot<ExecRecord>;
+    using GetterSnapshotPtr = std::shared_ptr<const GetterSnapshot>;
+    using ExecSnapshotPtr   = std::shared_ptr<const ExecSnapshot>;
+
+    // Records written after a given version.
+    struct StateDelta {
+        uint64_t version{0};           // pass back as "since" on the next call
+        std::vector<std::shared_ptr<const GetterRecord>> getters;
+        std::vector<std::shared_ptr<const ExecRecord>> executors;
+    };
+
     // ------------------------------------------------------------
     // Type aliases
     // ------------------------------------------------------------
@@ -88,7 +277,6 @@ public:
     using GetterSchema     = std::unordered_map<std::string, ValueType>;
     using ExecSchemaByName = std::unordered_map<std::string, ValueType>;
     using DcmBindingMap    = std::unordered_map<std::string, DcmBinding>;
-    using ExecMap          = std::unordered_map<int, ExecFullEntry>;
 
     // ------------------------------------------------------------
     // Singleton
@@ -104,8 +292,13 @@ public:
     // ------------------------------------------------------------
     // Time
     // ------------------------------------------------------------
+    // steady ms; simulated under tools::VirtualClock
     static uint64_t nowMs() {
         using namespace std::chrono;
+
+        const auto& vc = tools::VirtualClock::instance();
+        if (vc.enabled()) return vc.steadyMs();
+
         return static_cast<uint64_t>(
             duration_cast<milliseconds>(
                 steady_clock::now().time_since_epoch()
@@ -117,8 +310,11 @@ public:
     // Schema registration
     // ------------------------------------------------------------
     void setGetterSchema(const std::string& key, ValueType t) {
-        std::unique_lock lk(schema_mtx_);
-        getter_schema_[key] = t;
+        {
+            std::unique_lock lk(schema_mtx_);
+            getter_schema_[key] = t;
+        }
+        registerGetter(key, t);
     }
 
     void setExecSchemaByName(const std::string& name, ValueType t) {
@@ -132,8 +328,106 @@ public:
     }
 
     void registerExecNameToId(const std::string& name, int id) {
-        std::unique_lock lk(exec_mtx_);
-        exec_name_to_id_[name] = id;
+        (void)registerExecutor(name, id);
+    }
+
+    // ------------------------------------------------------------
+    // Handle registration (idempotent)
+    // ------------------------------------------------------------
+    GetterHandle registerGetter(const std::string& key, ValueType t) {
+        std::lock_guard<std::mutex> lk(getter_write_mtx_);
+
+        const uint32_t slot = getterSlotForKeyLocked(key, t);
+        if (loadGetters()->slots[slot]->type != t) {
+            publishSlot(getter_table_, slot, [&](GetterRecord& r) { r.type = t; });
+        }
+
+        // preallocate history at registration, not in the DataGetter tick
+        if (keepsHistory(t)) history_.attach(slot);
+
+        return GetterHandle{slot};
+    }
+
+    ExecHandle registerExecutor(const std::string& name, int id) {
+        ValueType t = ValueType::BOOL;
+        {
+            std::shared_lock lk(schema_mtx_);
+            auto it = exec_schema_by_name_.find(name);
+            if (it != exec_schema_by_name_.end()) t = it->second;
+        }
+
+        std::lock_guard<std::mutex> lk(exec_write_mtx_);
+
+        const uint32_t slot = execSlotForIdLocked(id);
+        publishSlot(exec_table_, slot, [&](ExecRecord& r) {
+            r.name = name;
+            r.type = t;
+        });
+
+        auto idx = std::make_shared<ExecIndex>(*std::atomic_load(&exec_index_));
+        idx->byName[name] = slot;
+        std::atomic_store(&exec_index_, std::shared_ptr<const ExecIndex>(std::move(idx)));
+
+        return ExecHandle{slot};
+    }
+
+    // ------------------------------------------------------------
+    // Handle lookup
+    // ------------------------------------------------------------
+    GetterHandle getterHandle(const std::string& key) const {
+        GetterHandle h;
+        if (!findGetterHandle(key, h))
+            throw std::runtime_error("Getter key not found: " + key);
+        return h;
+    }
+
+    bool findGetterHandle(const std::string& key, GetterHandle& out) const {
+        const auto idx = std::atomic_load(&getter_index_);
+
+        auto it = idx->find(key);
+        if (it == idx->end()) return false;
+
+        out = GetterHandle{it->second};
+        return true;
+    }
+
+    ExecHandle execHandleByName(const std::string& name) const {
+        ExecHandle h;
+        if (!findExecHandle(name, h))
+            throw std::runtime_error("Executor name not found: " + name);
+        return h;
+    }
+
+    bool findExecHandle(const std::string& name, ExecHandle& out) const {
+        const auto idx = std::atomic_load(&exec_index_);
+
+        auto it = idx->byName.find(name);
+        if (it == idx->byName.end()) return false;
+
+        out = ExecHandle{it->second};
+        return true;
+    }
+
+    ExecHandle execHandleById(int id) const {
+        const auto idx = std::atomic_load(&exec_index_);
+
+        auto it = idx->byId.find(id);
+        if (it == idx->byId.end())
+            throw std::runtime_error("Executor id not found");
+
+        return ExecHandle{it->second};
+    }
+
+    int execId(ExecHandle h) const {
+        return execRecord(h)->id;
+    }
+
+    std::string execName(ExecHandle h) const {
+        return execRecord(h)->name;
+    }
+
+    ValueType execType(ExecHandle h) const {
+        return execRecord(h)->type;
     }
 
     // ------------------------------------------------------------
@@ -141,39 +435,31 @@ public:
     // ------------------------------------------------------------
     template<class T>
     T getGetterAs(const std::string& key) const {
-        std::shared_lock lk(getter_mtx_);
-
-        auto it = getter_status_.find(key);
-        if (it == getter_status_.end())
-            throw std::runtime_error("Getter key not found: " + key);
+        return getGetterAs<T>(getterHandle(key));
+    }
 
-        if (!it->second.valid)
-            throw std::runtime_error("Getter key invalid: " + key);
+    template<class T>
+    T getGetterAs(GetterHandle h) const {
+        const auto r = getterRecord(h);
+        if (!r->entry.valid)
+            throw std::runtime_error("Getter key invalid: " + r->key);
 
-        return std::any_cast<T>(it->second.value);
+        return r->entry.value.get<T>();
     }
 
     GetterEntry getGetterEntry(const std::string& key) const {
-        std::shared_lock lk(getter_mtx_);
-
-        auto it = getter_status_.find(key);
-        if (it == getter_status_.end())
-            throw std::runtime_error("Getter key not found: " + key);
+        return getterRecord(getterHandle(key))->entry;
+    }
 
-        return it->second;
+    GetterEntry getGetterEntry(GetterHandle h) const {
+        return getterRecord(h)->entry;
     }
 
     // ------------------------------------------------------------
     // Executor name/id helpers
     // ------------------------------------------------------------
     int execIdByName(const std::string& name) const {
-        std::shared_lock lk(exec_mtx_);
-
-        auto it = exec_name_to_id_.find(name);
-        if (it == exec_name_to_id_.end())
-            throw std::runtime_error("Executor name not found: " + name);
-
-        return it->second;
+        return execId(execHandleByName(name));
     }
 
     DcmBinding getDcmBindingByName(const std::string& name) const {
@@ -190,43 +476,31 @@ public:
     // Executor read helpers (NEW)
     // ------------------------------------------------------------
     ExecFullEntry getExecFullEntry(int id) const {
-        std::shared_lock lk(exec_mtx_);
-
-        auto it = executor_status_.find(id);
-        if (it == executor_status_.end())
-            throw std::runtime_error("Executor id not found");
+        return execRecord(execHandleById(id))->state;
+    }
 
-        return it->second;
+    ExecFullEntry getExecFullEntry(ExecHandle h) const {
+        return execRecord(h)->state;
     }
 
     ExecDesiredEntry getExecDesiredEntry(int id) const {
-        std::shared_lock lk(exec_mtx_);
-
-        auto it = executor_status_.find(id);
-        if (it == executor_status_.end())
-            throw std::runtime_error("Executor id not found");
+        return execRecord(execHandleById(id))->state.desired;
+    }
 
-        return it->second.desired;
+    ExecDesiredEntry getExecDesiredEntry(ExecHandle h) const {
+        return execRecord(h)->state.desired;
     }
 
     ExecActualEntry getExecActualEntry(int id) const {
-        std::shared_lock lk(exec_mtx_);
-
-        auto it = executor_status_.find(id);
-        if (it == executor_status_.end())
-            throw std::runtime_error("Executor id not found");
+        return execRecord(execHandleById(id))->state.actual;
+    }
 
-        return it->second.actual;
+    ExecActualEntry getExecActualEntry(ExecHandle h) const {
+        return execRecord(h)->state.actual;
     }
 
     bool isExecDirty(int id) const {
-        std::shared_lock lk(exec_mtx_);
-
-        auto it = executor_status_.find(id);
-        if (it == executor_status_.end())
-            throw std::runtime_error("Executor id not found");
-
-        return it->second.desired.dirty;
+        return execRecord(execHandleById(id))->state.desired.dirty;
     }
 
     // ------------------------------------------------------------
@@ -250,7 +524,7 @@ public:
         if (!a.valid)
             throw std::runtime_error("Executor value invalid");
 
-        return std::any_cast<T>(a.value);
+        return a.value.get<T>();
     }
 
     GH_MODE getExecMode(int id) const {
@@ -275,13 +549,101 @@ public:
         return dcm_bindings_;
     }
 
+    // Shared immutable views: O(1), no copies, no lock held.
+    // Compare version with a previously seen snapshot to skip work.
+    GetterSnapshotPtr getterSnapshot() const {
+        return loadGetters();
+    }
+
+    ExecSnapshotPtr execSnapshot() const {
+        return loadExecs();
+    }
+
+    // ------------------------------------------------------------
+    // Write observer
+    // Called for every getter write and every executor desired /
+    // actual value, validity or mode change. It runs on the writing
+    // thread under the table's writer lock, so calls arrive in write
+    // order; keep it cheap and never write GH_GlobalState from it.
+    // Used to feed persistent history and the state journal.
+    // ------------------------------------------------------------
+    enum class StateWriteKind : uint8_t { GETTER, EXEC_DESIRED, EXEC_ACTUAL };
+
+    struct StateWrite {
+        StateWriteKind kind;
+        const std::string& name;       // getter key or executor name
+        uint32_t slot;                 // getter or exec slot, stable for the process
+        int execId;                    // executors only
+        const Value& value;
+        bool valid;
+        GH_MODE mode;                  // executors only
+        bool modeOnly;                 // only mode or validity changed
+        uint64_t stampMs;
+    };
+
+    using WriteObserver = std::function<void(const StateWrite& w)>;
+
+    void setWriteObserver(WriteObserver fn) {
+        std::shared_ptr<const WriteObserver> p;
+        if (fn) p = std::make_shared<const WriteObserver>(std::move(fn));
+        std::atomic_store(&write_observer_, std::move(p));
+    }
+
+    // ------------------------------------------------------------
+    // Getter history (numeric getters, unix ms stamps)
+    // ------------------------------------------------------------
+    // nullptr if the getter keeps no history
+    const tools::HistorySeries* getterHistory(GetterHandle h) const {
+        return history_.series(h.slot);
+    }
+
+    const tools::HistorySeries* getterHistory(const std::string& key) const {
+        GetterHandle h;
+        if (!findGetterHandle(key, h)) return nullptr;
+        return getterHistory(h);
+    }
+
+    uint64_t stateVersion() const {
+        return state_version_.load(std::memory_order_acquire);
+    }
+
+    // Entries changed after since. The returned version is a safe
+    // watermark: every write stamped at or below it is already visible,
+    // so passing it back as since never skips a change.
+    StateDelta snapshotSince(uint64_t since) const {
+        const uint64_t global = state_version_.load();
+
+        GetterSnapshotPtr g;
+        ExecSnapshotPtr e;
+
+        StateDelta d;
+        d.version = std::min(watermark(getter_table_, global, g),
+                             watermark(exec_table_, global, e));
+        if (d.version < since) d.version = since;
+
+        for (const auto& r : g->slots) {
+            if (r->version > since) d.getters.push_back(r);
+        }
+        for (const auto& r : e->slots) {
+            if (r->version > since) d.executors.push_back(r);
+        }
+        return d;
+    }
+
     GetterMap snapshotGetters() const {
-        std::shared_lock lk(getter_mtx_);
-        return getter_status_;
+        const auto snap = loadGetters();
+
+        GetterMap out;
+        out.reserve(snap->slots.size());
+        for (const auto& r : snap->slots) {
+            out.emplace(r->key, r->entry);
+        }
+        return out;
     }
 
     struct ExecApiEntry {
         int id{0};
+        ExecHandle handle;
         std::string name;
         ExecEntry entry;               // compatibility actual state
         ExecDesiredEntry desired;      // new
@@ -289,31 +651,26 @@ public:
     };
 
     std::vector<ExecApiEntry> snapshotExecutors() const {
-        std::shared_lock lk(exec_mtx_);
-
-        std::unordered_map<int, std::string> id2name;
-        for (const auto& kv : exec_name_to_id_) {
-            id2name[kv.second] = kv.first;
-        }
+        const auto snap = loadExecs();
 
         std::vector<ExecApiEntry> out;
-        out.reserve(executor_status_.size());
+        out.reserve(snap->slots.size());
 
-        for (const auto& kv : executor_status_) {
-            ExecApiEntry e;
-            e.id = kv.first;
+        for (uint32_t i = 0; i < snap->slots.size(); ++i) {
+            const auto& r = *snap->slots[i];
 
-            auto it = id2name.find(kv.first);
-            if (it != id2name.end())
-                e.name = it->second;
+            ExecApiEntry e;
+            e.id = r.id;
+            e.handle = ExecHandle{i};
+            e.name = r.name;
 
-            e.desired = kv.second.desired;
-            e.actual = kv.second.actual;
+            e.desired = r.state.desired;
+            e.actual = r.state.actual;
 
-            e.entry.value = kv.second.actual.value;
-            e.entry.mode = kv.second.actual.mode;
-            e.entry.valid = kv.second.actual.valid;
-            e.entry.stampMs = kv.second.actual.stampMs;
+            e.entry.value = r.state.actual.value;
+            e.entry.mode = r.state.actual.mode;
+            e.entry.valid = r.state.actual.valid;
+            e.entry.stampMs = r.state.actual.stampMs;
 
             out.push_back(std::move(e));
         }
@@ -325,20 +682,31 @@ public:
     // Getter write helpers
     // ------------------------------------------------------------
     void setGetter(const std::string& key, std::any value) {
-        std::unique_lock lk(getter_mtx_);
+        setGetter(key, Value::fromAny(value));
+    }
 
-        auto& e = getter_status_[key];
-        e.value = std::move(value);
-        e.valid = true;
-        e.stampMs = nowMs();
+    void setGetter(const std::string& key, Value value) {
+        std::lock_guard<std::mutex> lk(getter_write_mtx_);
+
+        const uint32_t slot = getterSlotForKeyLocked(key, value.type);
+        writeGetterLocked(slot, std::move(value));
+    }
+
+    void setGetter(GetterHandle h, Value value) {
+        std::lock_guard<std::mutex> lk(getter_write_mtx_);
+        writeGetterLocked(h.slot, std::move(value));
     }
 
     void setGetterInvalid(const std::string& key) {
-        std::unique_lock lk(getter_mtx_);
+        std::lock_guard<std::mutex> lk(getter_write_mtx_);
+
+        const uint32_t slot = getterSlotForKeyLocked(key, ValueType::DOUBLE);
+        invalidateGetterLocked(slot);
+    }
 
-        auto& e = getter_status_[key];
-        e.valid = false;
-        e.stampMs = nowMs();
+    void setGetterInvalid(GetterHandle h) {
+        std::lock_guard<std::mutex> lk(getter_write_mtx_);
+        invalidateGetterLocked(h.slot);
     }
 
     // ------------------------------------------------------------
@@ -347,96 +715,254 @@ public:
     void setExecDesired(int id, std::any value, GH_MODE mode,
                         std::string writer = "unknown",
                         bool dirty = true) {
-        std::unique_lock lk(exec_mtx_);
+        setExecDesired(execHandleForWrite(id), Value::fromAny(value), mode, std::move(writer), dirty);
+    }
+
+    void setExecDesired(ExecHandle h, Value value, GH_MODE mode,
+                        std::string writer = "unknown",
+                        bool dirty = true) {
+        mutateExecDesired(h, dirty, Notify::VALUE, [&](ExecDesiredEntry& d) {
+            d.value = std::move(value);
+            d.mode = mode;
+            d.valid = true;
+            d.lastWriter = std::move(writer);
+            d.stampMs = nowMs();
+        });
+    }
+
+    // ------------------------------------------------------------
+    // Batched AUTO desired write: one lock, one published snapshot.
+    // Per entry, skipped when the executor is MANUAL (desired or
+    // actual) or when the write would change nothing: desired
+    // already holds the value in AUTO and is either still pending
+    // (dirty) or applied (actual matches). A diverged actual is
+    // written again so the bridge retries it.
+    // Handles must be unique. Returns the number of entries written;
+    // applied, when given, gets 1 / 0 per entry.
+    // ------------------------------------------------------------
+    struct ExecDesiredWrite {
+        ExecHandle handle;
+        Value value;
+    };
+
+    size_t commitExecDesired(const std::vector<ExecDesiredWrite>& writes,
+                             const std::string& writer,
+                             std::vector<uint8_t>* applied = nullptr) {
+        if (applied) applied->assign(writes.size(), 0);
+        if (writes.empty()) return 0;
+
+        std::vector<std::pair<uint32_t, std::shared_ptr<ExecRecord>>> written;
+        {
+            std::lock_guard<std::mutex> lk(exec_write_mtx_);
+
+            const auto cur = std::atomic_load(&exec_table_.snap);
+            const uint64_t stampMs = nowMs();
+
+            for (size_t k = 0; k < writes.size(); ++k) {
+                const auto& w = writes[k];
+                if (w.handle.slot >= cur->slots.size())
+                    throw std::runtime_error("Slot handle out of range");
+
+                const auto& st = cur->slots[w.handle.slot]->state;
+                if (st.actual.mode == GH_MODE::MANUAL || st.desired.mode == GH_MODE::MANUAL) continue;
+                if (st.desired.valid && st.desired.value == w.value &&
+                    (st.desired.dirty || (st.actual.valid && st.actual.value == w.value))) continue;
+
+                auto rec = std::make_shared<ExecRecord>(*cur->slots[w.handle.slot]);
+                auto& d = rec->state.desired;
+                d.value = w.value;
+                d.mode = GH_MODE::AUTO;
+                d.valid = true;
+                d.dirty = true;
+                d.lastWriter = writer;
+                d.stampMs = stampMs;
+                ++d.rev;
+
+                written.emplace_back(w.handle.slot, std::move(rec));
+                if (applied) (*applied)[k] = 1;
+            }
+
+            if (written.empty()) return 0;
+
+            auto next = std::make_shared<ExecSnapshot>();
+            next->slots = cur->slots;
+
+            // nothing below throws; the batch shares one stamp
+            exec_table_.writing.store(true);
+            next->version = nextVersion();
+            for (auto& [slot, rec] : written) {
+                rec->version = next->version;
+                next->slots[slot] = rec;
+            }
+
+            std::atomic_store(&exec_table_.snap, std::shared_ptr<const ExecSnapshot>(std::move(next)));
+            exec_table_.writing.store(false);
+
+            for (const auto& [slot, rec] : written) {
+                const auto& d = rec->state.desired;
+                notifyWrite(StateWrite{StateWriteKind::EXEC_DESIRED, rec->name, slot, rec->id, d.value,
+                                       d.valid, d.mode, false, d.stampMs});
+            }
+        }
 
-        auto& e = executor_status_[id];
-        e.desired.value = std::move(value);
-        e.desired.mode = mode;
-        e.desired.valid = true;
-        e.desired.dirty = dirty;
-        e.desired.lastWriter = std::move(writer);
-        e.desired.stampMs = nowMs();
+        // records are published before the bits, so a drain sees them
+        for (const auto& w : written) signalExecDirty(w.first);
+        return written.size();
     }
 
     void setExecDesiredInvalid(int id, std::string writer = "unknown", bool dirty = true) {
-        std::unique_lock lk(exec_mtx_);
+        setExecDesiredInvalid(execHandleForWrite(id), std::move(writer), dirty);
+    }
 
-        auto& e = executor_status_[id];
-        e.desired.valid = false;
-        e.desired.dirty = dirty;
-        e.desired.lastWriter = std::move(writer);
-        e.desired.stampMs = nowMs();
+    void setExecDesiredInvalid(ExecHandle h, std::string writer = "unknown", bool dirty = true) {
+        mutateExecDesired(h, dirty, Notify::MODE, [&](ExecDesiredEntry& d) {
+            d.valid = false;
+            d.lastWriter = std::move(writer);
+            d.stampMs = nowMs();
+        });
     }
 
     void setExecDesiredMode(int id, GH_MODE mode, std::string writer = "unknown", bool dirty = true) {
-        std::unique_lock lk(exec_mtx_);
+        setExecDesiredMode(execHandleForWrite(id), mode, std::move(writer), dirty);
+    }
 
-        auto& e = executor_status_[id];
-        e.desired.mode = mode;
-        e.desired.dirty = dirty;
-        e.desired.lastWriter = std::move(writer);
-        e.desired.stampMs = nowMs();
+    void setExecDesiredMode(ExecHandle h, GH_MODE mode, std::string writer = "unknown", bool dirty = true) {
+        mutateExecDesired(h, dirty, Notify::MODE, [&](ExecDesiredEntry& d) {
+            d.mode = mode;
+            d.lastWriter = std::move(writer);
+            d.stampMs = nowMs();
+        });
     }
 
     void markExecDirty(int id, bool dirty = true) {
-        std::unique_lock lk(exec_mtx_);
-        executor_status_[id].desired.dirty = dirty;
+        markExecDirty(execHandleForWrite(id), dirty);
+    }
+
+    void markExecDirty(ExecHandle h, bool dirty = true) {
+        mutateExecDesired(h, dirty, Notify::NONE, [](ExecDesiredEntry&) {});
+    }
+
+    // Clears dirty only if no desired write happened after the consumer
+    // read revision rev. Returns false if a newer write is still pending.
+    bool clearExecDirty(ExecHandle h, uint64_t rev) {
+        std::lock_guard<std::mutex> lk(exec_write_mtx_);
+
+        const auto cur = execRecord(h);
+        if (cur->state.desired.rev != rev) return false;
+        if (!cur->state.desired.dirty) return true;
+
+        publishSlot(exec_table_, h.slot, [](ExecRecord& r) { r.state.desired.dirty = false; });
+        return true;
+    }
+
+    // ------------------------------------------------------------
+    // Executor change feed
+    // Every write that marks an executor dirty also sets its bit here,
+    // so consumers drain only what changed instead of scanning.
+    // ------------------------------------------------------------
+    using ExecDirtyListener = std::function<void()>;
+
+    // Called outside state locks when the first change after a drain
+    // arrives; further changes before the next drain do not call again.
+    void setExecDirtyListener(ExecDirtyListener fn) {
+        std::shared_ptr<const ExecDirtyListener> p;
+        if (fn) p = std::make_shared<const ExecDirtyListener>(std::move(fn));
+        std::atomic_store(&exec_dirty_listener_, std::move(p));
+    }
+
+    // Appends handles marked since the previous drain. Single consumer.
+    size_t drainDirtyExecs(std::vector<ExecHandle>& out) {
+        // re-arm first: a mark racing with the drain wakes again
+        // instead of being lost
+        exec_dirty_notified_.store(false, std::memory_order_seq_cst);
+
+        size_t n = 0;
+        for (size_t w = 0; w < exec_dirty_bits_.size(); ++w) {
+            uint64_t bits = exec_dirty_bits_[w].exchange(0, std::memory_order_acq_rel);
+            while (bits) {
+                const int b = __builtin_ctzll(bits);
+                bits &= bits - 1;
+                out.push_back(ExecHandle{static_cast<uint32_t>(w * 64 + b)});
+                ++n;
+            }
+        }
+        return n;
     }
 
     // ------------------------------------------------------------
     // Executor actual write helpers (NEW)
     // ------------------------------------------------------------
     void setExecActual(int id, std::any value, GH_MODE mode, bool pending = false) {
-        std::unique_lock lk(exec_mtx_);
+        setExecActual(execHandleForWrite(id), Value::fromAny(value), mode, pending);
+    }
 
-        auto& e = executor_status_[id];
-        e.actual.value = std::move(value);
-        e.actual.mode = mode;
-        e.actual.valid = true;
-        e.actual.pending = pending;
-        e.actual.lastError.clear();
-        e.actual.stampMs = nowMs();
-        e.actual.lastAppliedMs = e.actual.stampMs;
+    void setExecActual(ExecHandle h, Value value, GH_MODE mode, bool pending = false) {
+        mutateExecActual(h, Notify::VALUE, [&](ExecActualEntry& a) {
+            a.value = std::move(value);
+            a.mode = mode;
+            a.valid = true;
+            a.pending = pending;
+            a.lastError.clear();
+            a.stampMs = nowMs();
+            a.lastAppliedMs = a.stampMs;
+        });
     }
 
     void setExecActualInvalid(int id, std::string err = {}) {
-        std::unique_lock lk(exec_mtx_);
+        setExecActualInvalid(execHandleForWrite(id), std::move(err));
+    }
 
-        auto& e = executor_status_[id];
-        e.actual.valid = false;
-        e.actual.pending = false;
-        e.actual.lastError = std::move(err);
-        e.actual.stampMs = nowMs();
+    void setExecActualInvalid(ExecHandle h, std::string err = {}) {
+        mutateExecActual(h, Notify::MODE, [&](ExecActualEntry& a) {
+            a.valid = false;
+            a.pending = false;
+            a.lastError = std::move(err);
+            a.stampMs = nowMs();
+        });
     }
 
     void setExecActualMode(int id, GH_MODE mode) {
-        std::unique_lock lk(exec_mtx_);
+        setExecActualMode(execHandleForWrite(id), mode);
+    }
 
-        auto& e = executor_status_[id];
-        e.actual.mode = mode;
-        e.actual.stampMs = nowMs();
+    void setExecActualMode(ExecHandle h, GH_MODE mode) {
+        mutateExecActual(h, Notify::MODE, [&](ExecActualEntry& a) {
+            a.mode = mode;
+            a.stampMs = nowMs();
+        });
     }
 
     void setExecPending(int id, bool pending) {
-        std::unique_lock lk(exec_mtx_);
+        setExecPending(execHandleForWrite(id), pending);
+    }
 
-        auto& e = executor_status_[id];
-        e.actual.pending = pending;
-        e.actual.stampMs = nowMs();
+    void setExecPending(ExecHandle h, bool pending) {
+        mutateExec(h, [&](ExecFullEntry& e) {
+            e.actual.pending = pending;
+            e.actual.stampMs = nowMs();
+        });
     }
 
     void setExecApplyError(int id, const std::string& err) {
-        std::unique_lock lk(exec_mtx_);
+        setExecApplyError(execHandleForWrite(id), err);
+    }
 
-        auto& e = executor_status_[id];
-        e.actual.lastError = err;
-        e.actual.pending = false;
-        e.actual.stampMs = nowMs();
+    void setExecApplyError(ExecHandle h, const std::string& err) {
+        mutateExec(h, [&](ExecFullEntry& e) {
+            e.actual.lastError = err;
+            e.actual.pending = false;
+            e.actual.stampMs = nowMs();
+        });
     }
 
     void clearExecApplyError(int id) {
-        std::unique_lock lk(exec_mtx_);
-        executor_status_[id].actual.lastError.clear();
+        clearExecApplyError(execHandleForWrite(id));
+    }
+
+    void clearExecApplyError(ExecHandle h) {
+        mutateExec(h, [&](ExecFullEntry& e) {
+            e.actual.lastError.clear();
+        });
     }
 
     // ------------------------------------------------------------
@@ -455,17 +981,284 @@ public:
     }
 
 private:
-    GH_GlobalState() = default;
+    GH_GlobalState()
+        : getter_index_(std::make_shared<const GetterIndex>()),
+          exec_index_(std::make_shared<const ExecIndex>()) {
+        getter_table_.snap = std::make_shared<const GetterSnapshot>();
+        exec_table_.snap = std::make_shared<const ExecSnapshot>();
+    }
+
+    template<class R>
+    struct Table {
+        std::shared_ptr<const Snapshot<R>> snap;   // std::atomic_load / std::atomic_store only
+        std::atomic<bool> writing{false};          // stamp taken, snapshot not yet published
+    };
+
+    using GetterIndex = std::unordered_map<std::string, uint32_t>;
+
+    struct ExecIndex {
+        std::unordered_map<std::string, uint32_t> byName;
+        std::unordered_map<int, uint32_t> byId;
+    };
+
+    // ------------------------------------------------------------
+    // Snapshot plumbing
+    // ------------------------------------------------------------
+    GetterSnapshotPtr loadGetters() const { return std::atomic_load(&getter_table_.snap); }
+    ExecSnapshotPtr loadExecs() const { return std::atomic_load(&exec_table_.snap); }
+
+    // Highest version below which this table has no unpublished writes.
+    // Call after reading state_version_ into global. A writer raises
+    // writing before taking its stamp, so if writing reads false here
+    // every stamp up to global is already in the loaded snapshot.
+    template<class R>
+    static uint64_t watermark(const Table<R>& t, uint64_t global,
+                              std::shared_ptr<const Snapshot<R>>& snap) {
+        const bool busy = t.writing.load();
+        snap = std::atomic_load(&t.snap);
+        return busy ? snap->version : global;
+    }
 
-    mutable std::shared_mutex exec_mtx_;
-    mutable std::shared_mutex getter_mtx_;
+    // Keeps the snapshot alive together with the record it points into.
+    std::shared_ptr<const GetterRecord> getterRecord(GetterHandle h) const {
+        const auto snap = loadGetters();
+        if (h.slot >= snap->slots.size())
+            throw std::runtime_error("Getter handle out of range");
+        return snap->slots[h.slot];
+    }
+
+    std::shared_ptr<const ExecRecord> execRecord(ExecHandle h) const {
+        const auto snap = loadExecs();
+        if (h.slot >= snap->slots.size())
+            throw std::runtime_error("Executor handle out of range");
+        return snap->slots[h.slot];
+    }
+
+    // caller holds the table's writer mutex
+    template<class R, class Fn>
+    std::shared_ptr<const R> publishSlot(Table<R>& table, uint32_t slot, Fn&& fn) {
+        const auto cur = std::atomic_load(&table.snap);
+        if (slot >= cur->slots.size())
+            throw std::runtime_error("Slot handle out of range");
+
+        auto rec = std::make_shared<R>(*cur->slots[slot]);
+        fn(*rec);
+
+        auto next = std::make_shared<Snapshot<R>>();
+        next->slots = cur->slots;
+
+        // nothing below throws
+        table.writing.store(true);
+        rec->version = nextVersion();
+        next->version = rec->version;
+        next->slots[slot] = rec;
+
+        std::atomic_store(&table.snap, std::shared_ptr<const Snapshot<R>>(std::move(next)));
+        table.writing.store(false);
+        return rec;
+    }
+
+    // caller holds the table's writer mutex
+    template<class R>
+    uint32_t appendSlot(Table<R>& table, R rec) {
+        const auto cur = std::atomic_load(&table.snap);
+
+        auto r = std::make_shared<R>(std::move(rec));
+        auto next = std::make_shared<Snapshot<R>>();
+        next->slots.reserve(cur->slots.size() + 1);
+        next->slots = cur->slots;
+
+        // nothing below throws
+        table.writing.store(true);
+        r->version = nextVersion();
+        next->version = r->version;
+        next->slots.push_back(std::move(r));
+
+        const auto slot = static_cast<uint32_t>(cur->slots.size());
+        std::atomic_store(&table.snap, std::shared_ptr<const Snapshot<R>>(std::move(next)));
+        table.writing.store(false);
+        return slot;
+    }
+
+    // taken under the table's writer mutex, so each table publishes
+    // its stamps in increasing order
+    uint64_t nextVersion() {
+        return state_version_.fetch_add(1) + 1;
+    }
+
+    // ------------------------------------------------------------
+    // Getter writers (getter_write_mtx_ held)
+    // ------------------------------------------------------------
+    uint32_t getterSlotForKeyLocked(const std::string& key, ValueType t) {
+        const auto idx = std::atomic_load(&getter_index_);
+
+        auto it = idx->find(key);
+        if (it != idx->end()) return it->second;
+
+        GetterRecord r;
+        r.key = key;
+        r.type = t;
+        const uint32_t slot = appendSlot(getter_table_, std::move(r));
+
+        auto next = std::make_shared<GetterIndex>(*idx);
+        next->emplace(key, slot);
+        std::atomic_store(&getter_index_, std::shared_ptr<const GetterIndex>(std::move(next)));
+
+        return slot;
+    }
+
+    void writeGetterLocked(uint32_t slot, Value value) {
+        const bool numeric = keepsHistory(value.type) && value.hasValue();
+        const double v = numeric ? value.toDouble() : 0.0;
+
+        auto rec = publishSlot(getter_table_, slot, [&](GetterRecord& r) {
+            r.entry.value = std::move(value);
+            r.entry.valid = true;
+            r.entry.stampMs = nowMs();
+        });
+
+        // getter_write_mtx_ makes this the single history writer
+        if (numeric) {
+            tools::HistorySeries* h = history_.seriesMut(slot);
+            if (!h) h = history_.attach(slot);
+            if (h) h->push(tools::nowUnixMs(), v);
+        }
+
+        notifyWrite(StateWrite{StateWriteKind::GETTER, rec->key, slot, -1, rec->entry.value,
+                               true, GH_MODE::AUTO, false, rec->entry.stampMs});
+    }
+
+    static bool keepsHistory(ValueType t) {
+        return t == ValueType::BOOL || t == ValueType::INT || t == ValueType::DOUBLE;
+    }
+
+    void invalidateGetterLocked(uint32_t slot) {
+        publishSlot(getter_table_, slot, [&](GetterRecord& r) {
+            r.entry.valid = false;
+            r.entry.stampMs = nowMs();
+        });
+    }
+
+    // ------------------------------------------------------------
+    // Executor writers
+    // ------------------------------------------------------------
+    // exec_write_mtx_ held, inserts unknown ids
+    uint32_t execSlotForIdLocked(int id) {
+        const auto idx = std::atomic_load(&exec_index_);
+
+        auto it = idx->byId.find(id);
+        if (it != idx->byId.end()) return it->second;
+
+        if (loadExecs()->slots.size() >= GH_MAX_EXEC_SLOTS)
+            throw std::runtime_error("Too many executors, raise GH_MAX_EXEC_SLOTS");
+
+        ExecRecord r;
+        r.id = id;
+        const uint32_t slot = appendSlot(exec_table_, std::move(r));
+
+        auto next = std::make_shared<ExecIndex>(*idx);
+        next->byId.emplace(id, slot);
+        std::atomic_store(&exec_index_, std::shared_ptr<const ExecIndex>(std::move(next)));
+
+        return slot;
+    }
+
+    // what a write reports to the write observer
+    enum class Notify : uint8_t { NONE, VALUE, MODE };
+
+    template<class Fn>
+    void mutateExec(ExecHandle h, Fn&& fn) {
+        std::lock_guard<std::mutex> lk(exec_write_mtx_);
+        publishSlot(exec_table_, h.slot, [&](ExecRecord& r) { fn(r.state); });
+    }
+
+    template<class Fn>
+    void mutateExecActual(ExecHandle h, Notify notify, Fn&& fn) {
+        std::lock_guard<std::mutex> lk(exec_write_mtx_);
+
+        const auto rec = publishSlot(exec_table_, h.slot, [&](ExecRecord& r) { fn(r.state.actual); });
+        if (notify != Notify::NONE) {
+            const auto& a = rec->state.actual;
+            notifyWrite(StateWrite{StateWriteKind::EXEC_ACTUAL, rec->name, h.slot, rec->id, a.value,
+                                   a.valid, a.mode, notify == Notify::MODE, a.stampMs});
+        }
+    }
+
+    template<class Fn>
+    void mutateExecDesired(ExecHandle h, bool dirty, Notify notify, Fn&& fn) {
+        {
+            std::lock_guard<std::mutex> lk(exec_write_mtx_);
+
+            const auto rec = publishSlot(exec_table_, h.slot, [&](ExecRecord& r) {
+                fn(r.state.desired);
+                r.state.desired.dirty = dirty;
+                if (dirty) ++r.state.desired.rev;
+            });
+
+            if (notify != Notify::NONE) {
+                const auto& d = rec->state.desired;
+                notifyWrite(StateWrite{StateWriteKind::EXEC_DESIRED, rec->name, h.slot, rec->id, d.value,
+                                       d.valid, d.mode, notify == Notify::MODE, d.stampMs});
+            }
+        }
+
+        // record is published before the bit, so a drain sees the write
+        if (dirty) signalExecDirty(h.slot);
+    }
+
+    // caller holds the table's writer mutex
+    void notifyWrite(const StateWrite& w) {
+        const auto fn = std::atomic_load(&write_observer_);
+        if (fn && *fn) (*fn)(w);
+    }
+
+    void signalExecDirty(uint32_t slot) {
+        const uint64_t mask = uint64_t{1} << (slot % 64);
+        exec_dirty_bits_[slot / 64].fetch_or(mask, std::memory_order_acq_rel);
+
+        if (exec_dirty_notified_.exchange(true, std::memory_order_seq_cst)) return;
+
+        const auto fn = std::atomic_load(&exec_dirty_listener_);
+        if (fn && *fn) (*fn)();
+    }
+
+    // id based writes used to create entries on demand, keep that
+    ExecHandle execHandleForWrite(int id) {
+        {
+            const auto idx = std::atomic_load(&exec_index_);
+            auto it = idx->byId.find(id);
+            if (it != idx->byId.end()) return ExecHandle{it->second};
+        }
+
+        std::lock_guard<std::mutex> lk(exec_write_mtx_);
+        return ExecHandle{execSlotForIdLocked(id)};
+    }
+
+    // writers serialize here, readers never take these
+    std::mutex getter_write_mtx_;
+    std::mutex exec_write_mtx_;
     mutable std::shared_mutex schema_mtx_;
 
-    ExecMap executor_status_;
-    NameToId exec_name_to_id_;
-    GetterMap getter_status_;
+    Table<GetterRecord> getter_table_;
+    Table<ExecRecord> exec_table_;
+
+    // accessed only through std::atomic_load / std::atomic_store
+    std::shared_ptr<const GetterIndex> getter_index_;
+    std::shared_ptr<const ExecIndex> exec_index_;
+
+    std::atomic<uint64_t> state_version_{0};
+
+    // written under getter_write_mtx_ only
+    tools::HistoryStore history_;
+
+    // executor change feed, one bit per exec slot
+    std::array<std::atomic<uint64_t>, (GH_MAX_EXEC_SLOTS + 63) / 64> exec_dirty_bits_{};
+    std::atomic<bool> exec_dirty_notified_{false};
+    std::shared_ptr<const ExecDirtyListener> exec_dirty_listener_;
+
+    std::shared_ptr<const WriteObserver> write_observer_;
 
     GetterSchema getter_schema_;
     ExecSchemaByName exec_schema_by_name_;
     DcmBindingMap dcm_bindings_;
-};
\ No newline at end of file
+};
@@ -55,8 +55,16 @@ struct ActionModel {
     ActionValueType valueType{ActionValueType::BOOL};
     std::string value;               // literal as string, parsed later
     TriggerMode trigger{TriggerMode::ON_ENTER};
+    int priority{0};                 // higher wins when rules disagree on a target
 
     bool enabled{true};
 };
 
+inline bool operator==(const ActionModel& a, const ActionModel& b) {
+    return a.target == b.target && a.valueType == b.valueType && a.value == b.value &&
+           a.trigger == b.trigger && a.priority == b.priority && a.enabled == b.enabled;
+}
+
+inline bool operator!=(const ActionModel& a, const ActionModel& b) { return !(a == b); }
+
 } // namespace logic
\ No newline at end of file
@@ -1,158 +1,186 @@
 #pragma once
 
-#include <any>
-#include <cctype>
-#include <sstream>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
-#include <vector>
+#include <type_traits>
 
 #include "../GlobalState.hpp"
-#include "../Tools/DateTime.hpp"
+#include "RuleNode.hpp"
+#include "ConditionContext.hpp"
+#include "TimeContext.hpp"
 
 namespace logic {
 
+// ------------------------------------------------------------
+// One condition operand, classified once at rule load
+// ------------------------------------------------------------
+struct Operand {
+    enum class Kind : uint8_t { LITERAL, GETTER, TIME };
+
+    Kind kind{Kind::LITERAL};
+    TimeToken time{TimeToken::UNIX_MS};
+    GH_GlobalState::GetterHandle getter{};
+    ArgValue literal{};       // parsed as the condition's type
+    bool literalOk{false};
+    std::string token;        // source text, for errors
+};
+
+// ------------------------------------------------------------
+// Rule args: bind() classifies a token when the rules are loaded,
+// read() fetches its value at tick time in the condition's own
+// type. No string round trip and no exception on the normal path.
+// ------------------------------------------------------------
 class ArgumentResolver {
 public:
-    explicit ArgumentResolver(GH_GlobalState& gs)
+    explicit ArgumentResolver(const GH_GlobalState& gs)
         : gs_(gs) {}
 
     // ------------------------------------------------------------
-    // Resolve all args for one rule
-    // Returns stringified values ready for ConditionContext
+    // Classify one token: time token, then getter, then literal.
+    // A getter registered later stays a literal until the rules
+    // are compiled again.
     // ------------------------------------------------------------
-    std::vector<std::string> resolve(const std::vector<std::string>& args) const {
-        std::vector<std::string> out;
-        out.reserve(args.size());
-
-        for (const auto& a : args) {
-            out.push_back(resolveOne(a));
-        }
-
-        return out;
+    Operand bind(const std::string& token, CondType type) const {
+        Operand op;
+        op.token = token;
+
+        if (isTimeToken(token, op.time)) {
+            op.kind = Operand::Kind::TIME;
+            return op;
+        }
+
+        if (gs_.findGetterHandle(token, op.getter)) {
+            op.kind = Operand::Kind::GETTER;
+            return op;
+        }
+
+        op.kind = Operand::Kind::LITERAL;
+        switch (type) {
+            case CondType::F64: {
+                double v = 0.0;
+                op.literalOk = ConditionContext::parseArg<double>(token, v);
+                op.literal = ArgValue::f64(v);
+                break;
+            }
+            case CondType::I64: {
+                long long v = 0;
+                op.literalOk = ConditionContext::parseArg<long long>(token, v);
+                op.literal = ArgValue::i64(v);
+                break;
+            }
+            case CondType::BOOL: {
+                bool v = false;
+                op.literalOk = ConditionContext::parseArg<bool>(token, v);
+                op.literal = ArgValue::boolean(v);
+                break;
+            }
+        }
+        return op;
     }
 
-    // ------------------------------------------------------------
-    // Resolve one token
-    // ------------------------------------------------------------
-    std::string resolveOne(const std::string& token) const {
-        // 1. special time helpers
-        if (isTimeToken(token)) {
-            return resolveTimeToken(token);
-        }
-
-        // 2. getter from GlobalState
-        if (hasGetter(token)) {
-            return getterToString(token);
-        }
-
-        // 3. literal
-        return token;
+    static bool isTimeToken(const std::string& token, TimeToken& out) {
+        if (token == "time.unix_ms")        { out = TimeToken::UNIX_MS;        return true; }
+        if (token == "time.hour")           { out = TimeToken::HOUR;           return true; }
+        if (token == "time.minute")         { out = TimeToken::MINUTE;         return true; }
+        if (token == "time.second")         { out = TimeToken::SECOND;         return true; }
+        if (token == "time.daily_hhmmss")   { out = TimeToken::DAILY_HHMMSS;   return true; }
+        if (token == "time.seconds_of_day") { out = TimeToken::SECONDS_OF_DAY; return true; }
+        if (token == "time.year")           { out = TimeToken::YEAR;           return true; }
+        if (token == "time.month")          { out = TimeToken::MONTH;          return true; }
+        if (token == "time.day")            { out = TimeToken::DAY;            return true; }
+        if (token == "time.day_of_year")    { out = TimeToken::DAY_OF_YEAR;    return true; }
+        return false;
     }
 
-private:
-    GH_GlobalState& gs_;
-
     // ------------------------------------------------------------
-    // Getter existence check
+    // Value of a bound operand. false: not representable in T
+    // (bad literal, non 0/1 for bool, unparsable string).
+    // Throws only for an invalid or empty getter.
     // ------------------------------------------------------------
-    bool hasGetter(const std::string& key) const {
-        try {
-            (void)gs_.getGetterEntry(key);
-            return true;
-        } catch (...) {
-            return false;
-        }
+    template<typename T>
+    static bool read(const Operand& op,
+                     const GH_GlobalState::GetterSnapshot& getters,
+                     const TimeContext& time,
+                     T& out) {
+        switch (op.kind) {
+            case Operand::Kind::LITERAL:
+                if (!op.literalOk) return false;
+                out = fromArgValue<T>(op.literal);
+                return true;
+
+            case Operand::Kind::TIME:
+                return fromInteger(time.value(op.time), out);
+
+            case Operand::Kind::GETTER: {
+                const auto& e = getters.slots[op.getter.slot]->entry;
+                if (!e.valid) {
+                    throw std::runtime_error("Getter invalid: " + op.token);
+                }
+                if (!e.value.hasValue()) {
+                    throw std::runtime_error("Getter has no value: " + op.token);
+                }
+                return fromValue(e.value, out);
+            }
+        }
+        return false;
     }
 
     // ------------------------------------------------------------
-    // Convert getter any -> string
+    // Native conversions. bool accepts only 0 / 1, like the
+    // "true"/"1"/"false"/"0" literals; strings are parsed with
+    // the literal rules.
     // ------------------------------------------------------------
-    std::string getterToString(const std::string& key) const {
-        auto e = gs_.getGetterEntry(key);
+    template<typename T>
+    static bool fromInteger(long long v, T& out) {
+        if constexpr (std::is_same_v<T, bool>) {
+            if (v != 0 && v != 1) return false;
+            out = v == 1;
+        } else {
+            out = static_cast<T>(v);
+        }
+        return true;
+    }
 
-        if (!e.valid) {
-            throw std::runtime_error("Getter invalid: " + key);
-        }
+    template<typename T>
+    static bool fromValue(const GH_GlobalState::Value& v, T& out) {
+        using VT = GH_GlobalState::ValueType;
 
-        const auto& a = e.value;
-        if (!a.has_value()) {
-            throw std::runtime_error("Getter has no value: " + key);
-        }
+        switch (v.type) {
+            case VT::BOOL:
+                out = static_cast<T>(v.num.b);
+                return true;
 
-        const auto& t = a.type();
+            case VT::INT:
+                return fromInteger(v.num.i, out);
 
-        if (t == typeid(bool)) {
-            return std::any_cast<bool>(a) ? "true" : "false";
-        }
+            case VT::TIME:
+                return fromInteger(v.num.ms, out);
 
-        if (t == typeid(int)) {
-            return std::to_string(std::any_cast<int>(a));
-        }
+            case VT::DOUBLE:
+                if constexpr (std::is_same_v<T, bool>) {
+                    if (v.num.d != 0.0 && v.num.d != 1.0) return false;
+                    out = v.num.d == 1.0;
+                } else {
+                    out = static_cast<T>(v.num.d);
+                }
+                return true;
 
-        if (t == typeid(double)) {
-            std::ostringstream oss;
-            oss << std::any_cast<double>(a);
-            return oss.str();
+            case VT::STRING:
+                return ConditionContext::parseArg<T>(v.str, out);
         }
-
-        if (t == typeid(std::string)) {
-            return std::any_cast<std::string>(a);
-        }
-
-        if (t == typeid(tools::UnixMs)) {
-            return std::to_string(std::any_cast<tools::UnixMs>(a).value);
-        }
-
-        throw std::runtime_error("Unsupported getter type for key: " + key);
+        return false;
     }
 
-    // ------------------------------------------------------------
-    // Time helper support
-    // ------------------------------------------------------------
-    static bool isTimeToken(const std::string& token) {
-        return token == "time.unix_ms" ||
-               token == "time.hour" ||
-               token == "time.minute" ||
-               token == "time.second" ||
-               token == "time.daily_hhmmss";
+    template<typename T>
+    static T fromArgValue(const ArgValue& a) {
+        if constexpr (std::is_same_v<T, double>)         return a.d;
+        else if constexpr (std::is_same_v<T, long long>) return a.i;
+        else                                             return a.b;
     }
 
-    std::string resolveTimeToken(const std::string& token) const {
-        const long long now = tools::nowUnixMs();
-        const auto dt = tools::fromUnixMs(now);
-
-        if (token == "time.unix_ms") {
-            return std::to_string(now);
-        }
-
-        if (token == "time.hour") {
-            return std::to_string(dt.hour);
-        }
-
-        if (token == "time.minute") {
-            return std::to_string(dt.minute);
-        }
-
-        if (token == "time.second") {
-            return std::to_string(dt.second);
-        }
-
-        if (token == "time.daily_hhmmss") {
-            // e.g. 09:30:05 -> 93005 or with zeros -> 093005 as string
-            std::ostringstream oss;
-            oss.fill('0');
-            oss.width(2);
-            oss << dt.hour;
-            oss.width(2);
-            oss << dt.minute;
-            oss.width(2);
-            oss << dt.second;
-            return oss.str();
-        }
-
-        throw std::runtime_error("Unknown time token: " + token);
-    }
+private:
+    const GH_GlobalState& gs_;
 };
 
-} // namespace logic
\ No newline at end of file
+} // namespace logic
@@ -1,106 +1,212 @@
 #pragma once
 
+#include <algorithm>
 #include <cctype>
+#include <climits>
+#include <cmath>
 #include <cstdint>
+#include <initializer_list>
 #include <iostream>
-#include <memory>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
 
+#include "RuleNode.hpp"
+
 namespace logic {
 
+// Most operands any condition takes. Operands are passed in an
+// inline array of this size; a condition checks n before reading.
+constexpr size_t kMaxCondArgs = 4;
+
 // ------------------------------------------------------------
-// Base typed condition strategy
+// Condition functions. Every strategy below is a stateless type
+// with static test() and next(); the registry keeps plain
+// function pointers to them, so a call is one indirect jump.
 // ------------------------------------------------------------
 template<typename T>
-class IConditionStrategy {
-public:
-    virtual ~IConditionStrategy() = default;
-    virtual bool evaluate(const std::vector<T>& args) const = 0;
-};
+using CondTestFn = bool (*)(const T* args, size_t n);
+
+// Smallest args[0] above the current one at which test() may
+// change, other args fixed (args[0] is the time in time-driven
+// rules). numeric max: never changes. false: not predictable.
+template<typename T>
+using CondNextFn = bool (*)(const T* args, size_t n, T& next);
+
+// ------------------------------------------------------------
+// Next-change helpers
+// ------------------------------------------------------------
+
+// smallest T greater than v
+template<typename T>
+T nextAbove(T v) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::nextafter(v, std::numeric_limits<T>::infinity());
+    } else {
+        return v < std::numeric_limits<T>::max() ? v + 1 : v;
+    }
+}
+
+// the result of a comparison on x can only flip at one of points
+template<typename T>
+bool nextBreak(T x, std::initializer_list<T> points, T& next) {
+    next = std::numeric_limits<T>::max();
+    for (const T p : points) {
+        if (p > x && p < next) next = p;
+    }
+    return true;
+}
+
+// same for (x % mod): residues, and the wrap back to 0
+template<typename T>
+bool nextModBreak(T x, T mod, std::initializer_list<T> residues, T& next) {
+    if (mod <= 0) {
+        next = std::numeric_limits<T>::max();   // always false
+        return true;
+    }
+    if (x < 0) return false;
+
+    const T r = x % mod;
+    T best = mod;
+    for (const T p : residues) {
+        if (p > r && p < best) best = p;
+    }
+    if (x - r > std::numeric_limits<T>::max() - best) return false;
+    next = x - r + best;
+    return true;
+}
 
 // ------------------------------------------------------------
 // Generic strategies
 // ------------------------------------------------------------
 template<typename T>
-class CondGreater final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 2 && args[0] > args[1];
+struct CondGreater {
+    static bool test(const T* a, size_t n) {
+        return n == 2 && a[0] > a[1];
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 2 && nextBreak(a[0], {nextAbove(a[1])}, out);
     }
 };
 
 template<typename T>
-class CondLess final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 2 && args[0] < args[1];
+struct CondLess {
+    static bool test(const T* a, size_t n) {
+        return n == 2 && a[0] < a[1];
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 2 && nextBreak(a[0], {a[1]}, out);
     }
 };
 
 template<typename T>
-class CondEqual final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 2 && args[0] == args[1];
+struct CondEqual {
+    static bool test(const T* a, size_t n) {
+        return n == 2 && a[0] == a[1];
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 2 && nextBreak(a[0], {a[1], nextAbove(a[1])}, out);
     }
 };
 
 template<typename T>
-class CondNotEqual final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 2 && args[0] != args[1];
+struct CondNotEqual {
+    static bool test(const T* a, size_t n) {
+        return n == 2 && a[0] != a[1];
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 2 && nextBreak(a[0], {a[1], nextAbove(a[1])}, out);
     }
 };
 
 template<typename T>
-class CondGreaterEqual final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 2 && args[0] >= args[1];
+struct CondGreaterEqual {
+    static bool test(const T* a, size_t n) {
+        return n == 2 && a[0] >= a[1];
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 2 && nextBreak(a[0], {a[1]}, out);
     }
 };
 
 template<typename T>
-class CondLessEqual final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 2 && args[0] <= args[1];
+struct CondLessEqual {
+    static bool test(const T* a, size_t n) {
+        return n == 2 && a[0] <= a[1];
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 2 && nextBreak(a[0], {nextAbove(a[1])}, out);
     }
 };
 
 template<typename T>
-class CondInRange final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 3 && args[0] >= args[1] && args[0] <= args[2];
+struct CondInRange {
+    static bool test(const T* a, size_t n) {
+        return n == 3 && a[0] >= a[1] && a[0] <= a[2];
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 3 && nextBreak(a[0], {a[1], nextAbove(a[2])}, out);
     }
 };
 
 template<typename T>
-class CondOutOfRange final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 3 && (args[0] < args[1] || args[0] > args[2]);
+struct CondOutOfRange {
+    static bool test(const T* a, size_t n) {
+        return n == 3 && (a[0] < a[1] || a[0] > a[2]);
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 3 && nextBreak(a[0], {a[1], nextAbove(a[2])}, out);
     }
 };
 
 template<typename T>
-class CondAlways final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>&) const override {
+struct CondAlways {
+    static bool test(const T*, size_t) {
+        return true;
+    }
+    static bool next(const T*, size_t, T& out) {
+        out = std::numeric_limits<T>::max();
         return true;
     }
 };
 
 template<typename T>
-class CondNever final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>&) const override {
+struct CondNever {
+    static bool test(const T*, size_t) {
+        return false;
+    }
+    static bool next(const T*, size_t, T& out) {
+        out = std::numeric_limits<T>::max();
+        return true;
+    }
+};
+
+// ------------------------------------------------------------
+// bool strategies (no next(): bool operands never come from time)
+// ------------------------------------------------------------
+struct CondIsTrue {
+    static bool test(const bool* a, size_t n) {
+        return n == 1 && a[0];
+    }
+};
+
+struct CondIsFalse {
+    static bool test(const bool* a, size_t n) {
+        return n == 1 && !a[0];
+    }
+};
+
+struct CondAlwaysBool {
+    static bool test(const bool*, size_t) {
+        return true;
+    }
+};
+
+struct CondNeverBool {
+    static bool test(const bool*, size_t) {
         return false;
     }
 };
@@ -111,104 +217,247 @@ public:
 
 // ((data % (part * partCnt)) / part) == whichPart
 template<typename T>
-class CondModPart final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 4 &&
-               args[1] > 0 &&
-               args[2] > 0 &&
-               (((args[0] % (args[1] * args[2])) / args[1]) == args[3]);
+struct CondModPart {
+    static bool test(const T* a, size_t n) {
+        return n == 4 &&
+               a[1] > 0 &&
+               a[2] > 0 &&
+               (((a[0] % (a[1] * a[2])) / a[1]) == a[3]);
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        if (n != 4) return false;
+        if (a[1] <= 0 || a[2] <= 0) {
+            out = std::numeric_limits<T>::max();
+            return true;
+        }
+        return nextModBreak(a[0], a[1] * a[2], {a[1] * a[3], a[1] * (a[3] + 1)}, out);
     }
 };
 
 // (data % mod) < threshold
 template<typename T>
-class CondModLess final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 3 &&
-               args[1] > 0 &&
-               ((args[0] % args[1]) < args[2]);
+struct CondModLess {
+    static bool test(const T* a, size_t n) {
+        return n == 3 && a[1] > 0 && ((a[0] % a[1]) < a[2]);
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 3 && nextModBreak(a[0], a[1], {a[2]}, out);
     }
 };
 
 // (data % mod) <= threshold
 template<typename T>
-class CondModLessEqual final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 3 &&
-               args[1] > 0 &&
-               ((args[0] % args[1]) <= args[2]);
+struct CondModLessEqual {
+    static bool test(const T* a, size_t n) {
+        return n == 3 && a[1] > 0 && ((a[0] % a[1]) <= a[2]);
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 3 && nextModBreak(a[0], a[1], {a[2] + 1}, out);
     }
 };
 
 // (data % mod) > threshold
 template<typename T>
-class CondModGreater final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 3 &&
-               args[1] > 0 &&
-               ((args[0] % args[1]) > args[2]);
+struct CondModGreater {
+    static bool test(const T* a, size_t n) {
+        return n == 3 && a[1] > 0 && ((a[0] % a[1]) > a[2]);
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 3 && nextModBreak(a[0], a[1], {a[2] + 1}, out);
     }
 };
 
 // (data % mod) >= threshold
 template<typename T>
-class CondModGreaterEqual final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 3 &&
-               args[1] > 0 &&
-               ((args[0] % args[1]) >= args[2]);
+struct CondModGreaterEqual {
+    static bool test(const T* a, size_t n) {
+        return n == 3 && a[1] > 0 && ((a[0] % a[1]) >= a[2]);
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 3 && nextModBreak(a[0], a[1], {a[2]}, out);
     }
 };
 
 // (data % mod) == value
 template<typename T>
-class CondModEqual final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 3 &&
-               args[1] > 0 &&
-               ((args[0] % args[1]) == args[2]);
+struct CondModEqual {
+    static bool test(const T* a, size_t n) {
+        return n == 3 && a[1] > 0 && ((a[0] % a[1]) == a[2]);
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 3 && nextModBreak(a[0], a[1], {a[2], a[2] + 1}, out);
     }
 };
 
 // (data % mod) != value
 template<typename T>
-class CondModNotEqual final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        return args.size() == 3 &&
-               args[1] > 0 &&
-               ((args[0] % args[1]) != args[2]);
+struct CondModNotEqual {
+    static bool test(const T* a, size_t n) {
+        return n == 3 && a[1] > 0 && ((a[0] % a[1]) != a[2]);
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 3 && nextModBreak(a[0], a[1], {a[2], a[2] + 1}, out);
     }
 };
 
 // from <= (data % mod) <= to
 template<typename T>
-class CondModInRange final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        if (args.size() != 4 || args[1] <= 0) return false;
-        const T v = args[0] % args[1];
-        return v >= args[2] && v <= args[3];
+struct CondModInRange {
+    static bool test(const T* a, size_t n) {
+        if (n != 4 || a[1] <= 0) return false;
+        const T v = a[0] % a[1];
+        return v >= a[2] && v <= a[3];
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 4 && nextModBreak(a[0], a[1], {a[2], a[3] + 1}, out);
     }
 };
 
 // (data % mod) < from || (data % mod) > to
 template<typename T>
-class CondModOutOfRange final : public IConditionStrategy<T> {
-public:
-    bool evaluate(const std::vector<T>& args) const override {
-        if (args.size() != 4 || args[1] <= 0) return false;
-        const T v = args[0] % args[1];
-        return v < args[2] || v > args[3];
+struct CondModOutOfRange {
+    static bool test(const T* a, size_t n) {
+        if (n != 4 || a[1] <= 0) return false;
+        const T v = a[0] % a[1];
+        return v < a[2] || v > a[3];
+    }
+    static bool next(const T* a, size_t n, T& out) {
+        return n == 4 && nextModBreak(a[0], a[1], {a[2], a[3] + 1}, out);
     }
 };
 
+// ------------------------------------------------------------
+// Temporal strategies (double operands). Besides the operands they
+// get the node's TemporalState and the tick's unix ms, and set next
+// to the unix ms at which the result may change with unchanged
+// operands (LLONG_MAX: only on new input). Evaluating again with
+// the same operands at the same instant gives the same result.
+// ------------------------------------------------------------
+using CondTemporalFn = bool (*)(const double* args, size_t n, TemporalState& st,
+                                long long nowMs, long long& next);
+
+constexpr long long kDefaultDeltaWindowMs = 10000;
+
+inline long long toWholeMs(double ms) {
+    if (!(ms > 0.0)) return 0;
+    return ms >= 9.2e18 ? LLONG_MAX : static_cast<long long>(std::ceil(ms));
+}
+
+// in_range_for(x, lo, hi, ms): lo <= x <= hi without a break for ms
+struct CondInRangeFor {
+    static bool test(const double* a, size_t n, TemporalState& st, long long now, long long& next) {
+        next = LLONG_MAX;
+        if (n != 4) return false;
+
+        if (a[0] < a[1] || a[0] > a[2]) {
+            st.sinceMs = LLONG_MIN;
+            return false;
+        }
+        if (st.sinceMs == LLONG_MIN || st.sinceMs > now) st.sinceMs = now;
+
+        const long long hold = toWholeMs(a[3]);
+        if (now - st.sinceMs >= hold) return true;
+        next = st.sinceMs + hold;
+        return false;
+    }
+};
+
+// hysteresis(x, lo, hi): on above hi, off below lo, kept in between
+// (cooling, venting)
+struct CondHysteresis {
+    static bool test(const double* a, size_t n, TemporalState& st, long long, long long& next) {
+        next = LLONG_MAX;
+        if (n != 3) return false;
+
+        if (a[0] > a[2])      st.result = true;
+        else if (a[0] < a[1]) st.result = false;
+        return st.result;
+    }
+};
+
+// hysteresis_low(x, lo, hi): on below lo, off above hi (heating)
+struct CondHysteresisLow {
+    static bool test(const double* a, size_t n, TemporalState& st, long long, long long& next) {
+        next = LLONG_MAX;
+        if (n != 3) return false;
+
+        if (a[0] < a[1])      st.result = true;
+        else if (a[0] > a[2]) st.result = false;
+        return st.result;
+    }
+};
+
+// rising(x) / falling(x): direction of the last change of x, kept
+// while x stays put; false until x has changed once
+template<bool Up>
+struct CondDirection {
+    static bool test(const double* a, size_t n, TemporalState& st, long long now, long long& next) {
+        next = LLONG_MAX;
+        if (n != 1) return false;
+
+        if (st.refMs != LLONG_MIN && a[0] != st.refValue) {
+            st.result = Up ? a[0] > st.refValue : a[0] < st.refValue;
+        }
+        st.refValue = a[0];
+        st.refMs = now;
+        return st.result;
+    }
+};
+
+// delta_gt(x, per_s [, window_ms]) / delta_lt: change of x per
+// second over consecutive windows (default 10 s). The result is
+// updated when a window closes and held until the next one.
+template<bool Greater>
+struct CondDelta {
+    static bool test(const double* a, size_t n, TemporalState& st, long long now, long long& next) {
+        next = LLONG_MAX;
+        if (n != 2 && n != 3) return false;
+
+        const long long window = n == 3 ? std::max(1LL, toWholeMs(a[2])) : kDefaultDeltaWindowMs;
+
+        if (st.refMs == LLONG_MIN || now < st.refMs) {
+            st.refValue = a[0];
+            st.refMs = now;
+            st.result = false;
+        } else if (now - st.refMs >= window) {
+            const double rate = (a[0] - st.refValue) * 1000.0 / static_cast<double>(now - st.refMs);
+            st.result = Greater ? rate > a[1] : rate < a[1];
+            st.refValue = a[0];
+            st.refMs = now;
+        }
+
+        next = st.refMs > LLONG_MAX - window ? LLONG_MAX : st.refMs + window;
+        return st.result;
+    }
+};
+
+// ------------------------------------------------------------
+// Operand type a condition works on
+// ------------------------------------------------------------
+enum class CondType : uint8_t { F64, I64, BOOL };
+
+// ------------------------------------------------------------
+// Functions of one registered condition
+// ------------------------------------------------------------
+template<typename T>
+struct CondFns {
+    CondTestFn<T> test{nullptr};
+    CondNextFn<T> next{nullptr};   // nullptr: not predictable
+};
+
+// ------------------------------------------------------------
+// Condition looked up once by name (RuleProgram compile time)
+// ------------------------------------------------------------
+struct CondRef {
+    CondType type{CondType::F64};
+    CondFns<double>    f64{};
+    CondFns<long long> i64{};
+    CondFns<bool>      b{};
+    CondTemporalFn     temporal{nullptr};   // F64; f64 is empty then
+
+    bool valid() const { return f64.test || i64.test || b.test || temporal; }
+};
+
 // ------------------------------------------------------------
 // ConditionContext
 // ------------------------------------------------------------
@@ -216,172 +465,238 @@ class ConditionContext {
 public:
     ConditionContext() {
         // double
-        addStrategy<double>("gt", std::make_unique<CondGreater<double>>());
-        addStrategy<double>("lt", std::make_unique<CondLess<double>>());
-        addStrategy<double>("eq", std::make_unique<CondEqual<double>>());
-        addStrategy<double>("neq", std::make_unique<CondNotEqual<double>>());
-        addStrategy<double>("gte", std::make_unique<CondGreaterEqual<double>>());
-        addStrategy<double>("lte", std::make_unique<CondLessEqual<double>>());
-        addStrategy<double>("in_range", std::make_unique<CondInRange<double>>());
-        addStrategy<double>("out_of_range", std::make_unique<CondOutOfRange<double>>());
-        addStrategy<double>("always", std::make_unique<CondAlways<double>>());
-        addStrategy<double>("never", std::make_unique<CondNever<double>>());
+        add<double, CondGreater<double>>("gt");
+        add<double, CondLess<double>>("lt");
+        add<double, CondEqual<double>>("eq");
+        add<double, CondNotEqual<double>>("neq");
+        add<double, CondGreaterEqual<double>>("gte");
+        add<double, CondLessEqual<double>>("lte");
+        add<double, CondInRange<double>>("in_range");
+        add<double, CondOutOfRange<double>>("out_of_range");
+        add<double, CondAlways<double>>("always");
+        add<double, CondNever<double>>("never");
 
         // int64 / long long
-        addStrategy<long long>("gt_i64", std::make_unique<CondGreater<long long>>());
-        addStrategy<long long>("lt_i64", std::make_unique<CondLess<long long>>());
-        addStrategy<long long>("eq_i64", std::make_unique<CondEqual<long long>>());
-        addStrategy<long long>("neq_i64", std::make_unique<CondNotEqual<long long>>());
-        addStrategy<long long>("gte_i64", std::make_unique<CondGreaterEqual<long long>>());
-        addStrategy<long long>("lte_i64", std::make_unique<CondLessEqual<long long>>());
-        addStrategy<long long>("in_range_i64", std::make_unique<CondInRange<long long>>());
-        addStrategy<long long>("out_of_range_i64", std::make_unique<CondOutOfRange<long long>>());
-        addStrategy<long long>("always_i64", std::make_unique<CondAlways<long long>>());
-        addStrategy<long long>("never_i64", std::make_unique<CondNever<long long>>());
+        add<long long, CondGreater<long long>>("gt_i64");
+        add<long long, CondLess<long long>>("lt_i64");
+        add<long long, CondEqual<long long>>("eq_i64");
+        add<long long, CondNotEqual<long long>>("neq_i64");
+        add<long long, CondGreaterEqual<long long>>("gte_i64");
+        add<long long, CondLessEqual<long long>>("lte_i64");
+        add<long long, CondInRange<long long>>("in_range_i64");
+        add<long long, CondOutOfRange<long long>>("out_of_range_i64");
+        add<long long, CondAlways<long long>>("always_i64");
+        add<long long, CondNever<long long>>("never_i64");
 
         // modulo-based int64
-        addStrategy<long long>("mod_part", std::make_unique<CondModPart<long long>>());
-        addStrategy<long long>("mod_lt", std::make_unique<CondModLess<long long>>());
-        addStrategy<long long>("mod_lte", std::make_unique<CondModLessEqual<long long>>());
-        addStrategy<long long>("mod_gt", std::make_unique<CondModGreater<long long>>());
-        addStrategy<long long>("mod_gte", std::make_unique<CondModGreaterEqual<long long>>());
-        addStrategy<long long>("mod_eq", std::make_unique<CondModEqual<long long>>());
-        addStrategy<long long>("mod_neq", std::make_unique<CondModNotEqual<long long>>());
-        addStrategy<long long>("mod_in_range", std::make_unique<CondModInRange<long long>>());
-        addStrategy<long long>("mod_out_of_range", std::make_unique<CondModOutOfRange<long long>>());
+        add<long long, CondModPart<long long>>("mod_part");
+        add<long long, CondModLess<long long>>("mod_lt");
+        add<long long, CondModLessEqual<long long>>("mod_lte");
+        add<long long, CondModGreater<long long>>("mod_gt");
+        add<long long, CondModGreaterEqual<long long>>("mod_gte");
+        add<long long, CondModEqual<long long>>("mod_eq");
+        add<long long, CondModNotEqual<long long>>("mod_neq");
+        add<long long, CondModInRange<long long>>("mod_in_range");
+        add<long long, CondModOutOfRange<long long>>("mod_out_of_range");
 
         // bool
-        addStrategy<bool>("is_true", std::make_unique<CondEqual<bool>>());
-        addStrategy<bool>("is_false", std::make_unique<CondEqual<bool>>());
-        addStrategy<bool>("always_bool", std::make_unique<CondAlways<bool>>());
-        addStrategy<bool>("never_bool", std::make_unique<CondNever<bool>>());
+        add<bool, CondIsTrue>("is_true");
+        add<bool, CondIsFalse>("is_false");
+        add<bool, CondAlwaysBool>("always_bool");
+        add<bool, CondNeverBool>("never_bool");
+
+        // temporal, double, state kept per node
+        addTemporal<CondInRangeFor>("in_range_for");
+        addTemporal<CondHysteresis>("hysteresis");
+        addTemporal<CondHysteresisLow>("hysteresis_low");
+        addTemporal<CondDirection<true>>("rising");
+        addTemporal<CondDirection<false>>("falling");
+        addTemporal<CondDelta<true>>("delta_gt");
+        addTemporal<CondDelta<false>>("delta_lt");
     }
 
+    // String path: name lookup and literal parsing on every call.
+    // RuleEngine resolves both once through find() instead.
     bool check(const std::string& key, const std::vector<std::string>& args) const {
-        if (boolStrategies().count(key)) {
-            return checkTyped<bool>(key, args);
+        CondRef ref;
+        if (!find(key, ref)) {
+            std::cerr << "[LOGIC] Condition not found: " << key << "\n";
+            return false;
         }
 
-        if (i64Strategies().count(key)) {
-            return checkTyped<long long>(key, args);
+        switch (ref.type) {
+            case CondType::F64:  return checkTyped<double>(key, ref, args);
+            case CondType::I64:  return checkTyped<long long>(key, ref, args);
+            case CondType::BOOL: return checkTyped<bool>(key, ref, args);
         }
+        return false;
+    }
+
+    // lookup order: bool, then int64, then double, then temporal
+    bool find(const std::string& key, CondRef& out) const {
+        out = CondRef{};
 
-        if (doubleStrategies().count(key)) {
-            return checkTyped<double>(key, args);
+        if (auto it = table<bool>().find(key); it != table<bool>().end()) {
+            out.type = CondType::BOOL;
+            out.b = it->second;
+            return true;
         }
 
-        std::cerr << "[LOGIC] Condition not found: " << key << "\n";
-        return false;
-    }
+        if (auto it = table<long long>().find(key); it != table<long long>().end()) {
+            out.type = CondType::I64;
+            out.i64 = it->second;
+            return true;
+        }
 
-    std::vector<std::string> listAll() const {
-        std::vector<std::string> out;
+        if (auto it = table<double>().find(key); it != table<double>().end()) {
+            out.type = CondType::F64;
+            out.f64 = it->second;
+            return true;
+        }
 
-        for (const auto& kv : doubleStrategies()) out.push_back(kv.first);
-        for (const auto& kv : i64Strategies()) out.push_back(kv.first);
-        for (const auto& kv : boolStrategies()) out.push_back(kv.first);
+        if (auto it = temporalTable().find(key); it != temporalTable().end()) {
+            out.type = CondType::F64;
+            out.temporal = it->second;
+            return true;
+        }
 
-        return out;
+        return false;
     }
 
-private:
-    template<typename T>
-    using StrategyMap = std::unordered_map<std::string, std::unique_ptr<IConditionStrategy<T>>>;
+    // Typed operands, already converted; ref must be valid() and of
+    // that type. n may exceed kMaxCondArgs, only the stored ones are read.
+    // A temporal condition evaluated here sees a fresh state at time 0.
+    static bool evaluate(const CondRef& ref, const double* args, size_t n) {
+        if (ref.temporal) {
+            TemporalState st;
+            long long next = 0;
+            return ref.temporal(args, n, st, 0, next);
+        }
+        return ref.f64.test(args, n);
+    }
 
-    template<typename T>
-    static StrategyMap<T>& strategies() {
-        static StrategyMap<T> mp;
-        return mp;
+    static bool evaluate(const CondRef& ref, const double* args, size_t n,
+                         TemporalState& st, long long nowMs, long long& next) {
+        return ref.temporal(args, n, st, nowMs, next);
     }
 
-    static StrategyMap<double>& doubleStrategies() {
-        return strategies<double>();
+    static bool evaluate(const CondRef& ref, const long long* args, size_t n) {
+        return ref.i64.test(args, n);
     }
 
-    static StrategyMap<long long>& i64Strategies() {
-        return strategies<long long>();
+    static bool evaluate(const CondRef& ref, const bool* args, size_t n) {
+        return ref.b.test(args, n);
     }
 
-    static StrategyMap<bool>& boolStrategies() {
-        return strategies<bool>();
+    // See CondNextFn.
+    static bool nextChange(const CondRef& ref, const double* args, size_t n, double& next) {
+        return ref.f64.next && ref.f64.next(args, n, next);
     }
 
-    template<typename T>
-    void addStrategy(const std::string& key, std::unique_ptr<IConditionStrategy<T>> strategy) {
-        strategies<T>()[key] = std::move(strategy);
+    static bool nextChange(const CondRef& ref, const long long* args, size_t n, long long& next) {
+        return ref.i64.next && ref.i64.next(args, n, next);
+    }
+
+    static bool nextChange(const CondRef&, const bool*, size_t, bool&) {
+        return false;
     }
 
+    // One literal, with the same rules check() applies to every arg.
     template<typename T>
-    bool checkTyped(const std::string& key, const std::vector<std::string>& args) const {
-        std::vector<T> converted;
-        if (!convertArgs<T>(args, converted)) {
-            std::cerr << "[LOGIC] Failed to convert args for condition: " << key << "\n";
+    static bool parseArg(const std::string& s, T& out) {
+        std::istringstream iss(s);
+        T v{};
+        iss >> v;
+        if (iss.fail()) {
             return false;
         }
+        out = v;
+        return true;
+    }
 
-        auto& mp = strategies<T>();
-        auto it = mp.find(key);
-        if (it == mp.end() || !it->second) {
-            std::cerr << "[LOGIC] Strategy not found: " << key << "\n";
-            return false;
-        }
+    std::vector<std::string> listAll() const {
+        std::vector<std::string> out;
 
-        if constexpr (std::is_same_v<T, bool>) {
-            if (key == "is_true") {
-                return converted.size() == 1 && converted[0] == true;
-            }
-            if (key == "is_false") {
-                return converted.size() == 1 && converted[0] == false;
-            }
-        }
+        for (const auto& kv : table<double>()) out.push_back(kv.first);
+        for (const auto& kv : table<long long>()) out.push_back(kv.first);
+        for (const auto& kv : table<bool>()) out.push_back(kv.first);
+        for (const auto& kv : temporalTable()) out.push_back(kv.first);
 
-        return it->second->evaluate(converted);
+        return out;
     }
 
+private:
     template<typename T>
-    static bool convertArgs(const std::vector<std::string>& args, std::vector<T>& out) {
+    using Table = std::unordered_map<std::string, CondFns<T>>;
+
+    // shared by all instances, filled once
+    template<typename T>
+    static Table<T>& table() {
+        static Table<T> mp;
+        return mp;
+    }
+
+    static std::unordered_map<std::string, CondTemporalFn>& temporalTable() {
+        static std::unordered_map<std::string, CondTemporalFn> mp;
+        return mp;
+    }
+
+    template<typename S>
+    void addTemporal(const std::string& key) {
+        temporalTable().emplace(key, &S::test);
+    }
+
+    template<typename T, typename S>
+    void add(const std::string& key) {
+        CondFns<T> fns;
+        fns.test = &S::test;
+        if constexpr (!std::is_same_v<T, bool>) {
+            fns.next = &S::next;
+        }
+        table<T>().emplace(key, fns);
+    }
+
+    template<typename T>
+    static bool checkTyped(const std::string& key, const CondRef& ref,
+                           const std::vector<std::string>& args) {
+        T converted[kMaxCondArgs]{};
         try {
-            for (const auto& s : args) {
-                std::istringstream iss(s);
+            for (size_t i = 0; i < args.size(); ++i) {
                 T v{};
-                iss >> v;
-                if (iss.fail()) {
+                if (!parseArg<T>(args[i], v)) {
+                    std::cerr << "[LOGIC] Failed to convert args for condition: " << key << "\n";
                     return false;
                 }
-                out.push_back(v);
+                if (i < kMaxCondArgs) converted[i] = v;
             }
-            return true;
         } catch (...) {
+            std::cerr << "[LOGIC] Failed to convert args for condition: " << key << "\n";
             return false;
         }
+
+        return evaluate(ref, converted, args.size());
     }
 };
 
 // ------------------------------------------------------------
-// bool specialization for convertArgs
+// bool specialization for parseArg
 // ------------------------------------------------------------
 template<>
-inline bool ConditionContext::convertArgs<bool>(const std::vector<std::string>& args,
-                                                std::vector<bool>& out) {
-    try {
-        for (const auto& s : args) {
-            std::string v = s;
-            for (auto& c : v) {
-                c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
-            }
+inline bool ConditionContext::parseArg<bool>(const std::string& s, bool& out) {
+    std::string v = s;
+    for (auto& c : v) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
 
-            if (v == "true" || v == "1") {
-                out.push_back(true);
-            } else if (v == "false" || v == "0") {
-                out.push_back(false);
-            } else {
-                return false;
-            }
-        }
+    if (v == "true" || v == "1") {
+        out = true;
+        return true;
+    }
+    if (v == "false" || v == "0") {
+        out = false;
         return true;
-    } catch (...) {
-        return false;
     }
+    return false;
 }
 
 } // namespace logic
\ No newline at end of file
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace logic {
+
+// Limits of one expression, checked when it is compiled. Operands
+// and the evaluation stack live in inline arrays of these sizes.
+constexpr size_t kMaxExprOperands = 16;
+constexpr size_t kMaxExprStack = 32;
+constexpr size_t kMaxExprNesting = 64;
+
+// ------------------------------------------------------------
+// Operations of the expression bytecode
+// ------------------------------------------------------------
+enum class ExprOp : uint8_t {
+    CONST, LOAD,                       // push value / operand
+    NEG, NOT, ABS,                     // unary
+    ADD, SUB, MUL, DIV, MOD, MIN, MAX, // arithmetic
+    LT, LE, GT, GE, EQ, NE,            // comparison, 0 / 1
+    AND, OR                            // logic, 0 / 1
+};
+
+struct ExprInstr {
+    ExprOp   op{ExprOp::CONST};
+    uint32_t index{0};   // LOAD: operand index
+    double   value{0.0}; // CONST
+};
+
+// ------------------------------------------------------------
+// Arithmetic condition, e.g. "temp - tempAPI > 5".
+//
+// Parsed once into postfix bytecode. Sub-expressions on constants
+// only are folded while parsing, so "(2 + 3) * 60" is one CONST.
+// Every value is a double; comparisons and logic give 0 / 1, and
+// a value is true when it is neither 0 nor NaN. && and || always
+// evaluate both sides.
+//
+// Identifiers (getter keys, time tokens) become operands: names()
+// lists them once each in first-use order, and eval() reads
+// vars[i] for names()[i]. eval() does not allocate.
+//
+// Grammar, loosest first:
+//   ||   &&   == !=   < <= > >=   + -   * / %   unary - !
+//   numbers, true, false, identifiers, ( ), min(a, b),
+//   max(a, b), abs(a)
+// ------------------------------------------------------------
+class Expression {
+public:
+    // false: error describes the problem and its position
+    static bool compile(const std::string& text, Expression& out, std::string& error) {
+        out = Expression{};
+        Parser p(text, out);
+        try {
+            const uint32_t root = p.parseOr(0);
+            p.skipSpace();
+            if (p.pos < text.size()) p.fail("unexpected '" + std::string(1, text[p.pos]) + "'");
+            size_t depth = 0;
+            p.emit(root, depth);
+        } catch (const ParseError& e) {
+            error = e.what;
+            out = Expression{};
+            return false;
+        }
+        return true;
+    }
+
+    const std::vector<std::string>& names() const { return names_; }
+    size_t size() const { return code_.size(); }
+    bool constant() const { return code_.size() == 1 && code_[0].op == ExprOp::CONST; }
+
+    double eval(const double* vars) const {
+        double st[kMaxExprStack];
+        size_t sp = 0;
+
+        for (const ExprInstr& in : code_) {
+            switch (in.op) {
+                case ExprOp::CONST: st[sp++] = in.value;        break;
+                case ExprOp::LOAD:  st[sp++] = vars[in.index];  break;
+                case ExprOp::NEG:
+                case ExprOp::NOT:
+                case ExprOp::ABS:   st[sp - 1] = apply(in.op, st[sp - 1]); break;
+                default: {
+                    const double b = st[--sp];
+                    st[sp - 1] = apply(in.op, st[sp - 1], b);
+                    break;
+                }
+            }
+        }
+        return sp ? st[0] : 0.0;
+    }
+
+    bool test(const double* vars) const { return truth(eval(vars)); }
+
+    static bool truth(double v) { return v != 0.0 && v == v; }
+
+    static double apply(ExprOp op, double a) {
+        switch (op) {
+            case ExprOp::NEG: return -a;
+            case ExprOp::NOT: return truth(a) ? 0.0 : 1.0;
+            case ExprOp::ABS: return std::fabs(a);
+            default:          return a;
+        }
+    }
+
+    static double apply(ExprOp op, double a, double b) {
+        switch (op) {
+            case ExprOp::ADD: return a + b;
+            case ExprOp::SUB: return a - b;
+            case ExprOp::MUL: return a * b;
+            case ExprOp::DIV: return a / b;
+            case ExprOp::MOD: return std::fmod(a, b);
+            case ExprOp::MIN: return b < a ? b : a;
+            case ExprOp::MAX: return b > a ? b : a;
+            case ExprOp::LT:  return a < b;
+            case ExprOp::LE:  return a <= b;
+            case ExprOp::GT:  return a > b;
+            case ExprOp::GE:  return a >= b;
+            case ExprOp::EQ:  return a == b;
+            case ExprOp::NE:  return a != b;
+            case ExprOp::AND: return truth(a) && truth(b);
+            case ExprOp::OR:  return truth(a) || truth(b);
+            default:          return a;
+        }
+    }
+
+private:
+    std::vector<ExprInstr> code_;
+    std::vector<std::string> names_;
+
+    struct ParseError {
+        std::string what;
+    };
+
+    // AST node, only alive while compiling
+    struct Node {
+        ExprOp   op{ExprOp::CONST};
+        uint32_t a{0};
+        uint32_t b{0};
+        uint32_t index{0};
+        double   value{0.0};
+    };
+
+    struct Parser {
+        const std::string& s;
+        Expression& out;
+        size_t pos{0};
+        std::vector<Node> nodes;
+
+        Parser(const std::string& text, Expression& e) : s(text), out(e) {}
+
+        [[noreturn]] void fail(const std::string& msg) const {
+            throw ParseError{msg + " at " + std::to_string(pos) + " in '" + s + "'"};
+        }
+
+        void skipSpace() {
+            while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos]))) ++pos;
+        }
+
+        bool eat(const char* tok) {
+            skipSpace();
+            size_t n = 0;
+            while (tok[n]) ++n;
+            if (s.compare(pos, n, tok) != 0) return false;
+            pos += n;
+            return true;
+        }
+
+        // "<" must not also match "<="
+        bool eatAlone(const char* tok, char notNext) {
+            const size_t at = pos;
+            if (!eat(tok)) return false;
+            if (pos < s.size() && s[pos] == notNext) {
+                pos = at;
+                return false;
+            }
+            return true;
+        }
+
+        uint32_t constant(double v) {
+            nodes.push_back(Node{ExprOp::CONST, 0, 0, 0, v});
+            return static_cast<uint32_t>(nodes.size() - 1);
+        }
+
+        // folds when every child is a constant
+        uint32_t unary(ExprOp op, uint32_t a) {
+            if (nodes[a].op == ExprOp::CONST) return constant(apply(op, nodes[a].value));
+            nodes.push_back(Node{op, a, 0, 0, 0.0});
+            return static_cast<uint32_t>(nodes.size() - 1);
+        }
+
+        uint32_t binary(ExprOp op, uint32_t a, uint32_t b) {
+            if (nodes[a].op == ExprOp::CONST && nodes[b].op == ExprOp::CONST) {
+                return constant(apply(op, nodes[a].value, nodes[b].value));
+            }
+            nodes.push_back(Node{op, a, b, 0, 0.0});
+            return static_cast<uint32_t>(nodes.size() - 1);
+        }
+
+        uint32_t parseOr(size_t depth) {
+            uint32_t l = parseAnd(depth);
+            while (eat("||")) l = binary(ExprOp::OR, l, parseAnd(depth));
+            return l;
+        }
+
+        uint32_t parseAnd(size_t depth) {
+            uint32_t l = parseEquality(depth);
+            while (eat("&&")) l = binary(ExprOp::AND, l, parseEquality(depth));
+            return l;
+        }
+
+        uint32_t parseEquality(size_t depth) {
+            uint32_t l = parseRelation(depth);
+            for (;;) {
+                if (eat("=="))      l = binary(ExprOp::EQ, l, parseRelation(depth));
+                else if (eat("!=")) l = binary(ExprOp::NE, l, parseRelation(depth));
+                else return l;
+            }
+        }
+
+        uint32_t parseRelation(size_t depth) {
+            uint32_t l = parseSum(depth);
+            for (;;) {
+                if (eat("<="))                l = binary(ExprOp::LE, l, parseSum(depth));
+                else if (eat(">="))           l = binary(ExprOp::GE, l, parseSum(depth));
+                else if (eatAlone("<", '<'))  l = binary(ExprOp::LT, l, parseSum(depth));
+                else if (eatAlone(">", '>'))  l = binary(ExprOp::GT, l, parseSum(depth));
+                else return l;
+            }
+        }
+
+        uint32_t parseSum(size_t depth) {
+            uint32_t l = parseProduct(depth);
+            for (;;) {
+                if (eat("+"))      l = binary(ExprOp::ADD, l, parseProduct(depth));
+                else if (eat("-")) l = binary(ExprOp::SUB, l, parseProduct(depth));
+                else return l;
+            }
+        }
+
+        uint32_t parseProduct(size_t depth) {
+            uint32_t l = parseUnary(depth);
+            for (;;) {
+                if (eat("*"))      l = binary(ExprOp::MUL, l, parseUnary(depth));
+                else if (eat("/")) l = binary(ExprOp::DIV, l, parseUnary(depth));
+                else if (eat("%")) l = binary(ExprOp::MOD, l, parseUnary(depth));
+                else return l;
+            }
+        }
+
+        uint32_t parseUnary(size_t depth) {
+            if (depth > kMaxExprNesting) fail("nested too deep");
+            if (eat("-"))             return unary(ExprOp::NEG, parseUnary(depth + 1));
+            if (eatAlone("!", '='))   return unary(ExprOp::NOT, parseUnary(depth + 1));
+            if (eat("+"))             return parseUnary(depth + 1);
+            return parsePrimary(depth);
+        }
+
+        uint32_t parsePrimary(size_t depth) {
+            skipSpace();
+            if (pos >= s.size()) fail("unexpected end");
+
+            const char c = s[pos];
+
+            if (c == '(') {
+                ++pos;
+                const uint32_t e = parseOr(depth + 1);
+                if (!eat(")")) fail("expected ')'");
+                return e;
+            }
+
+            if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+                const char* begin = s.c_str() + pos;
+                char* end = nullptr;
+                const double v = std::strtod(begin, &end);
+                if (end == begin) fail("bad number");
+                pos += static_cast<size_t>(end - begin);
+                return constant(v);
+            }
+
+            if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+                const size_t start = pos;
+                while (pos < s.size() &&
+                       (std::isalnum(static_cast<unsigned char>(s[pos])) || s[pos] == '_' || s[pos] == '.')) {
+                    ++pos;
+                }
+                const std::string name = s.substr(start, pos - start);
+
+                if (name == "true")  return constant(1.0);
+                if (name == "false") return constant(0.0);
+
+                if (eat("(")) return parseCall(name, depth);
+                return load(name);
+            }
+
+            fail("unexpected '" + std::string(1, c) + "'");
+        }
+
+        uint32_t parseCall(const std::string& name, size_t depth) {
+            const uint32_t a = parseOr(depth + 1);
+
+            if (name == "abs") {
+                if (!eat(")")) fail("abs() takes one argument");
+                return unary(ExprOp::ABS, a);
+            }
+            if (name == "min" || name == "max") {
+                if (!eat(",")) fail(name + "() takes two arguments");
+                const uint32_t b = parseOr(depth + 1);
+                if (!eat(")")) fail(name + "() takes two arguments");
+                return binary(name == "min" ? ExprOp::MIN : ExprOp::MAX, a, b);
+            }
+            fail("unknown function '" + name + "'");
+        }
+
+        uint32_t load(const std::string& name) {
+            uint32_t index = 0;
+            while (index < out.names_.size() && out.names_[index] != name) ++index;
+            if (index == out.names_.size()) {
+                if (index == kMaxExprOperands) fail("more than " + std::to_string(kMaxExprOperands) + " operands");
+                out.names_.push_back(name);
+            }
+            nodes.push_back(Node{ExprOp::LOAD, 0, 0, index, 0.0});
+            return static_cast<uint32_t>(nodes.size() - 1);
+        }
+
+        // postfix; depth tracks the stack the code will need
+        void emit(uint32_t n, size_t& depth) {
+            const Node& node = nodes[n];
+            switch (node.op) {
+                case ExprOp::CONST:
+                case ExprOp::LOAD:
+                    push(ExprInstr{node.op, node.index, node.value}, depth, 1);
+                    break;
+                case ExprOp::NEG:
+                case ExprOp::NOT:
+                case ExprOp::ABS:
+                    emit(node.a, depth);
+                    push(ExprInstr{node.op, 0, 0.0}, depth, 0);
+                    break;
+                default:
+                    emit(node.a, depth);
+                    emit(node.b, depth);
+                    push(ExprInstr{node.op, 0, 0.0}, depth, -1);
+                    break;
+            }
+        }
+
+        void push(const ExprInstr& in, size_t& depth, int delta) {
+            depth = static_cast<size_t>(static_cast<long>(depth) + delta);
+            if (depth > kMaxExprStack) {
+                pos = 0;
+                fail("needs more than " + std::to_string(kMaxExprStack) + " stack slots");
+            }
+            out.code_.push_back(in);
+        }
+    };
+};
+
+} // namespace logic
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <nlohmann/json.hpp>
+#include <sstream>
 #include <string>
 
 #include "RuleTree.hpp"
@@ -9,6 +10,27 @@ namespace logic {
 
 using json = nlohmann::json;
 
+// ------------------------------------------------------------
+// Operand -> string, same text the old string resolver produced
+// ------------------------------------------------------------
+inline std::string argValueToString(const ArgValue& a)
+{
+    switch (a.type) {
+        case ArgValue::Type::BOOL:
+            return a.b ? "true" : "false";
+
+        case ArgValue::Type::I64:
+            return std::to_string(a.i);
+
+        case ArgValue::Type::F64: {
+            std::ostringstream oss;
+            oss << a.d;
+            return oss.str();
+        }
+    }
+    return {};
+}
+
 // ------------------------------------------------------------
 // Runtime -> json
 // ------------------------------------------------------------
@@ -27,7 +49,7 @@ inline json runtimeToJson(const RuleRuntimeState& rt)
 
     j["resolvedArgs"] = json::array();
     for (const auto& a : rt.resolvedArgs)
-        j["resolvedArgs"].push_back(a);
+        j["resolvedArgs"].push_back(argValueToString(a));
 
     return j;
 }
@@ -43,6 +65,7 @@ inline json actionToJson(const ActionModel& a)
     j["valueType"] = toString(a.valueType);
     j["value"] = a.value;
     j["trigger"] = toString(a.trigger);
+    j["priority"] = a.priority;
     j["enabled"] = a.enabled;
 
     return j;
@@ -55,6 +78,8 @@ inline json nodeStructureToJson(const RuleNode* node)
 {
     json j;
 
+    if (!node->id().empty())
+        j["id"] = node->id();
     j["title"] = node->title();
     j["condition"] = node->condition();
 
@@ -62,6 +87,11 @@ inline json nodeStructureToJson(const RuleNode* node)
     for (const auto& a : node->args())
         j["args"].push_back(a);
 
+    if (node->minOnMs() > 0)
+        j["minOnMs"] = node->minOnMs();
+    if (node->minOffMs() > 0)
+        j["minOffMs"] = node->minOffMs();
+
     j["actions"] = json::array();
     for (const auto& a : node->actions())
         j["actions"].push_back(actionToJson(a));
@@ -97,6 +127,8 @@ inline json nodeFullToJson(const RuleNode* node)
 {
     json j;
 
+    if (!node->id().empty())
+        j["id"] = node->id();
     j["title"] = node->title();
     j["condition"] = node->condition();
 
@@ -104,6 +136,11 @@ inline json nodeFullToJson(const RuleNode* node)
     for (const auto& a : node->args())
         j["args"].push_back(a);
 
+    if (node->minOnMs() > 0)
+        j["minOnMs"] = node->minOnMs();
+    if (node->minOffMs() > 0)
+        j["minOffMs"] = node->minOffMs();
+
     j["runtime"] = runtimeToJson(node->runtime());
 
     j["actions"] = json::array();
@@ -10,6 +10,8 @@
 #include "RuleTree.hpp"
 #include "RuleNode.hpp"
 #include "RuleEngine.hpp"
+#include "RuleProgram.hpp"
+#include "RuleTreeDiff.hpp"
 #include "ActionModel.hpp"
 #include "LogicDebugJson.hpp"
 
@@ -30,10 +32,8 @@ public:
     // File operations
     // --------------------------------------------------------
     void loadFromFile() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        RuleTree newTree = loadTreeFromFileUnlocked(filePath_);
-        tree_ = std::move(newTree);
-        engine_.requestRefresh();
+        std::lock_guard<std::mutex> reload(reloadMutex_);
+        apply(loadTreeFromFileUnlocked(filePath_));
     }
 
     void reloadFromFile() {
@@ -46,11 +46,10 @@ public:
     }
 
     void uploadJson(const json& j) {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<std::mutex> reload(reloadMutex_);
         RuleTree newTree = loadTreeFromJsonUnlocked(j);
         saveJsonToFileUnlocked(filePath_, j);
-        tree_ = std::move(newTree);
-        engine_.requestRefresh();
+        apply(std::move(newTree));
     }
 
     // --------------------------------------------------------
@@ -73,31 +72,30 @@ public:
 
     json apiReload(const json& body = json::object()) {
         (void)body;
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<std::mutex> reload(reloadMutex_);
 
-        RuleTree newTree = loadTreeFromFileUnlocked(filePath_);
-        tree_ = std::move(newTree);
-        engine_.requestRefresh();
+        const RuleTreeDiff diff = apply(loadTreeFromFileUnlocked(filePath_));
 
         json res;
         res["ok"] = true;
         res["message"] = "logic reloaded from file";
         res["file"] = filePath_;
+        res["diff"] = diffToJson(diff);
         return res;
     }
 
     json apiUpload(const json& body) {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<std::mutex> reload(reloadMutex_);
 
         RuleTree newTree = loadTreeFromJsonUnlocked(body);
         saveJsonToFileUnlocked(filePath_, body);
-        tree_ = std::move(newTree);
-        engine_.requestRefresh();
+        const RuleTreeDiff diff = apply(std::move(newTree));
 
         json res;
         res["ok"] = true;
         res["message"] = "logic uploaded and applied";
         res["file"] = filePath_;
+        res["diff"] = diffToJson(diff);
         return res;
     }
 
@@ -111,9 +109,45 @@ private:
     RuleTree& tree_;
     RuleEngine& engine_;
     std::string filePath_;
-    mutable std::mutex mutex_;
+    mutable std::mutex mutex_;    // tick and readers
+    std::mutex reloadMutex_;      // one reload at a time; tree_ structure is stable under it
 
 private:
+    // ------------------------------------------------------------
+    // Publish a parsed tree (reloadMutex_ held).
+    // Compile and diff run without mutex_, so the logic tick is
+    // only held for the runtime copy and the pointer swaps. Nodes
+    // matched unchanged keep their state, so their on_enter /
+    // on_exit do not fire again. A refresh is requested only when
+    // nothing carried over (first load or an unrelated tree).
+    // ------------------------------------------------------------
+    RuleTreeDiff apply(RuleTree next) {
+        RuleProgram program = engine_.prepare(next);
+        const RuleTreeDiff diff = RuleTreeDiff::compute(tree_, next);
+
+        RuleTree old;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            diff.carryRuntime();
+            old = std::move(tree_);
+            tree_ = std::move(next);
+            engine_.install(program);
+            if (diff.kept == 0) engine_.requestRefresh();
+        }
+
+        // old tree and program are destroyed here, outside mutex_
+        return diff;
+    }
+
+    static json diffToJson(const RuleTreeDiff& d) {
+        json j;
+        j["kept"] = d.kept;
+        j["changed"] = d.changed;
+        j["added"] = d.added;
+        j["removed"] = d.removed;
+        return j;
+    }
+
     static TriggerMode parseTriggerMode(const std::string& s) {
         if (s == "on_enter")   return TriggerMode::ON_ENTER;
         if (s == "on_exit")    return TriggerMode::ON_EXIT;
@@ -169,6 +203,7 @@ private:
             action.valueType = parseActionValueType(a.at("valueType").get<std::string>());
             action.value = a.at("value").get<std::string>();
             action.trigger = parseTriggerMode(a.value("trigger", "on_enter"));
+            action.priority = a.value("priority", 0);
             action.enabled = a.value("enabled", true);
 
             actions.push_back(std::move(action));
@@ -178,6 +213,7 @@ private:
     }
 
     static std::unique_ptr<RuleNode> parseRuleNode(const json& j) {
+        const std::string id = j.value("id", "");
         const std::string title = j.value("title", "unnamed");
         const std::string condition = j.value("condition", "always");
         const auto args = parseStringArray(j, "args");
@@ -189,6 +225,8 @@ private:
             args,
             actions
         );
+        node->setId(id);
+        node->setDwell(j.value("minOnMs", 0LL), j.value("minOffMs", 0LL));
 
         if (j.contains("children")) {
             if (!j.at("children").is_array()) {
@@ -1,15 +1,29 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "../GlobalState.hpp"
+#include "../Tools/DateTime.hpp"
+#include "../Tools/ForkJoinPool.hpp"
+#include "../Tools/LogLinearHistogram.hpp"
 #include "RuleTree.hpp"
 #include "ConditionContext.hpp"
+#include "RuleProgram.hpp"
 #include "ArgumentResolver.hpp"
+#include "TimeContext.hpp"
 #include "ActionModel.hpp"
 
 namespace logic {
@@ -19,8 +33,7 @@ public:
     RuleEngine(GH_GlobalState& gs, RuleTree& tree)
         : gs_(gs),
           tree_(tree),
-          conditions_(),
-          resolver_(gs) {}
+          conditions_() {}
 
     RuleTree& tree() { return tree_; }
     const RuleTree& tree() const { return tree_; }
@@ -33,44 +46,451 @@ public:
         forceRefresh_ = true;
     }
 
+    // ------------------------------------------------------------
+    // Rebuild the program from tree(). Must be called after the
+    // tree is replaced (LogicJsonController does it on every load).
+    // Getter and executor names are bound here. Every node is
+    // evaluated in full on the next tick.
+    // ------------------------------------------------------------
+    void compile() {
+        RuleProgram p = prepare(tree_);
+        install(p);
+    }
+
+    // ------------------------------------------------------------
+    // Hot reload in two steps. prepare() compiles a tree that is
+    // not running yet and touches no engine state, so it can run
+    // without the tick lock. install() swaps the program in under
+    // the lock; p receives the old program, to be destroyed after
+    // the lock is released. tree() must already hold the new tree.
+    // ------------------------------------------------------------
+    RuleProgram prepare(RuleTree& tree) const {
+        return RuleProgram::compile(tree, gs_, conditions_);
+    }
+
+    void install(RuleProgram& p) {
+        std::swap(program_, p);
+        compiled_ = true;
+
+        const uint32_t n = static_cast<uint32_t>(program_.size());
+        dirty_.assign(n, 1);
+        marks_.resize(n);
+        for (uint32_t i = 0; i < n; ++i) marks_[i] = i;
+        nextMarks_.clear();
+        nextMarks_.reserve(n);
+
+        seenGetters_.assign(program_.getterDeps().size(), 0);
+        seenSnapshot_ = 0;
+        nextChange_.assign(n, LLONG_MIN);
+        lastUnixMs_ = LLONG_MIN;
+        nextWake_ = LLONG_MAX;
+
+        // instruction indices changed: node counters start over
+        profile_.assign(profiling_ ? n : 0, NodeProfile{});
+
+        buildSegments();
+    }
+
+    // ------------------------------------------------------------
+    // Opt-in parallel tick. With threads > 1 and a program of at
+    // least minInstrs nodes, the subtrees under the root are split
+    // into segments that threads-1 helpers and the ticking thread
+    // evaluate concurrently. Segments do not share state; their
+    // marks and fired actions are merged in pre-order, so results
+    // and writes are the same as a single-threaded tick.
+    // Call while the engine is not ticking.
+    // ------------------------------------------------------------
+    void setParallel(size_t threads, size_t minInstrs = 512) {
+        const size_t helpers = threads > 1 ? threads - 1 : 0;
+        if (!pool_ || pool_->helpers() != helpers) {
+            pool_.reset();
+            if (helpers > 0) pool_ = std::make_unique<tools::ForkJoinPool>(helpers);
+        }
+        parallelMin_ = minInstrs;
+        buildSegments();
+    }
+
+    size_t segmentCount() const { return segments_.size(); }
+
+    // ------------------------------------------------------------
+    // Reference mode: every node is re-evaluated on every tick, as
+    // before incremental ticks. Much slower; Bench/RuleEngineDiff.cpp
+    // runs it next to the incremental and parallel ticks to check
+    // that they fire the same actions.
+    // ------------------------------------------------------------
+    void setFullPass(bool on) { fullPass_ = on; }
+    bool fullPass() const { return fullPass_; }
+
+    const RuleProgram& program() const { return program_; }
+
+    // ------------------------------------------------------------
+    // Incremental tick.
+    //
+    // A node's condition is re-evaluated only when one of its
+    // getters was written, its predicted next change (time-driven
+    // nodes) is due, or its last evaluation failed; otherwise the
+    // cached localResult is reused. A node is visited when it is dirty, its effective
+    // result changes, it has WHILE_* actions, or it changed on the
+    // previous tick (so prevEffectiveResult settles). A stable node
+    // with nothing marked below it skips its whole subtree.
+    // Triggers fire exactly as with a full pass.
+    // ------------------------------------------------------------
     void tick() {
-        auto* root = tree_.root();
-        if (!root) return;
+        if (!compiled_) compile();
+        commit_ = CommitStats{};
+
+        const auto& instrs = program_.instrs();
+        if (instrs.empty()) return;
+
+        const auto started = profiling_ ? Clock::now() : Clock::time_point{};
+
+        const auto getters = gs_.getterSnapshot();
+        const uint64_t now = nowMs();
+
+        // one instant for every node of this tick
+        timeSource_.sample();
+        markChanged(*getters);
+        if (fullPass_) markAll();
+
+        const uint32_t n = static_cast<uint32_t>(instrs.size());
+
+        if (segments_.empty()) {
+            outs_[0].clear();
+            run(0, n, outs_[0], *getters, now);
+        } else {
+            // the root first, then its subtrees side by side
+            outs_[0].clear();
+            run(0, 1, outs_[0], *getters, now);
+
+            auto job = [&](size_t k) {
+                EvalOut& out = outs_[k + 1];
+                out.clear();
+                run(segments_[k].first, segments_[k].second, out, *getters, now);
+            };
+            pool_->run(segments_.size(), job);
+        }
 
-        evaluateNode(root, true);
+        // pre-order merge: outs_ are in ascending instruction order
+        nextMarks_.clear();
+        for (const auto& out : outs_) {
+            nextMarks_.insert(nextMarks_.end(), out.nextMarks.begin(), out.nextMarks.end());
+        }
 
+        commitWrites();
+        marks_.swap(nextMarks_);
         forceRefresh_ = false;
+        nextWake_ = earliestChange();
+
+        if (profiling_) {
+            tickUs_.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started).count()));
+        }
     }
 
+    // ------------------------------------------------------------
+    // Unix ms at which the earliest time-driven condition may change
+    // (after the last tick), LLONG_MAX if none is predictable. Ticking
+    // right then catches the edge on the millisecond.
+    // ------------------------------------------------------------
+    long long nextWakeUnixMs() const { return nextWake_; }
+
+    // ------------------------------------------------------------
+    // Action writes of the last tick
+    // ------------------------------------------------------------
+    struct CommitStats {
+        uint32_t fired{0};        // actions that fired
+        uint32_t overridden{0};   // lost arbitration to another action
+        uint32_t staged{0};       // one per target executor
+        uint32_t written{0};      // actually changed desired state
+    };
+
+    const CommitStats& lastCommit() const { return commit_; }
+
+    // ------------------------------------------------------------
+    // Optional profiler. Counters live in a flat array indexed like
+    // program().instrs(), apart from the nodes, and cost nothing
+    // while disabled. Enabling starts from zero; install() clears
+    // the node counters since the indices change. Read under the
+    // tick lock.
+    // ------------------------------------------------------------
+    struct NodeProfile {
+        uint64_t visits{0};       // evaluate() calls
+        uint64_t evals{0};        // of which the condition was evaluated
+        uint64_t trueCount{0};    // condition results, after dwell
+        uint64_t falseCount{0};   // including failed evaluations
+        uint64_t totalNs{0};      // time in evaluate(), actions included
+        uint64_t maxNs{0};
+        uint64_t fires{0};        // actions fired
+        uint64_t overridden{0};   // fired, lost arbitration
+        uint64_t unchanged{0};    // won, the commit changed nothing
+    };
+
+    void setProfiling(bool on) {
+        if (on && !profiling_) resetProfile();
+        profiling_ = on;
+    }
+
+    bool profiling() const { return profiling_; }
+
+    void resetProfile() {
+        profile_.assign(program_.size(), NodeProfile{});
+        tickUs_.reset();
+    }
+
+    // empty until profiling was enabled for the current program
+    const std::vector<NodeProfile>& profile() const { return profile_; }
+    const tools::LogLinearHistogram& tickUs() const { return tickUs_; }
+
 private:
     GH_GlobalState& gs_;
     RuleTree& tree_;
     ConditionContext conditions_;
-    ArgumentResolver resolver_;
+    RuleProgram program_;
+    bool compiled_{false};
     bool forceRefresh_{false};
+    bool fullPass_{false};
+
+    // incremental state, reset by compile()
+    std::vector<uint8_t>  dirty_;         // per instr: condition must be re-evaluated
+    std::vector<uint32_t> marks_;         // instrs to visit this tick, ascending
+    std::vector<uint32_t> nextMarks_;     // carried to the next tick
+    std::vector<uint64_t> seenGetters_;   // per getter dependency: record version
+    uint64_t seenSnapshot_{0};
+    TimeSource timeSource_;
+
+    // per instr: unix ms of the next possible change of a timed
+    // condition; LLONG_MIN = unpredictable, re-evaluate every tick
+    std::vector<long long> nextChange_;
+    long long lastUnixMs_{LLONG_MIN};
+    long long nextWake_{LLONG_MAX};
+
+    // what one evaluation range produced in a tick
+    struct Fired {
+        GH_GlobalState::ExecHandle exec;
+        const CompiledAction* action;
+        uint32_t node;
+    };
+
+    struct EvalOut {
+        std::vector<uint32_t> nextMarks;   // carried to the next tick, ascending
+        std::vector<Fired> fired;          // in pre-order
+
+        void clear() {
+            nextMarks.clear();
+            fired.clear();
+        }
+    };
+
+    // outs_[0]: whole program, or only the root when segments_ is
+    // set; outs_[k + 1]: segments_[k]
+    std::vector<EvalOut> outs_{1};
+    std::vector<std::pair<uint32_t, uint32_t>> segments_;   // [first, end), ascending
+    std::unique_ptr<tools::ForkJoinPool> pool_;
+    size_t parallelMin_{512};
+
+    // per-tick write set: one winning action per target executor,
+    // committed at the end of the tick
+    static constexpr uint32_t kNotStaged = 0xFFFFFFFFu;
+    std::vector<const CompiledAction*> staged_;
+    std::vector<uint32_t> stagedBySlot_;   // exec slot -> staged_ index
+    std::vector<GH_GlobalState::ExecDesiredWrite> writes_;
+    std::vector<uint32_t> stagedNode_;     // per staged_: instr that fired it
+    std::vector<uint8_t> applied_;
+    CommitStats commit_;
+
+    using Clock = std::chrono::steady_clock;
+    bool profiling_{false};
+    std::vector<NodeProfile> profile_;
+    tools::LogLinearHistogram tickUs_;
 
 private:
     static uint64_t nowMs() {
         return GH_GlobalState::nowMs();
     }
 
-    void evaluateNode(RuleNode* node, bool parentEffective) {
-        if (!node) return;
+    // ------------------------------------------------------------
+    // Change detection
+    // ------------------------------------------------------------
+    void markChanged(const GH_GlobalState::GetterSnapshot& getters) {
+        const size_t carried = marks_.size();
+
+        // an unchanged table version means no getter was written
+        if (getters.version != seenSnapshot_) {
+            const auto& deps = program_.getterDeps();
+            for (size_t k = 0; k < deps.size(); ++k) {
+                const uint64_t v = getters.slots[deps[k].key]->version;
+                if (v == seenGetters_[k]) continue;
+                seenGetters_[k] = v;
+                markDependents(deps[k]);
+            }
+            seenSnapshot_ = getters.version;
+        }
+
+        // a clock stepped backwards voids every prediction
+        const long long nowUnix = timeSource_.current().unixMs;
+        const bool stepped = nowUnix < lastUnixMs_;
+        for (const uint32_t i : program_.timed()) {
+            if (stepped || nowUnix >= nextChange_[i]) mark(i);
+        }
+        lastUnixMs_ = nowUnix;
+
+        if (marks_.size() != carried) {
+            std::sort(marks_.begin(), marks_.end());
+            marks_.erase(std::unique(marks_.begin(), marks_.end()), marks_.end());
+        }
+    }
+
+    void markDependents(const Dependency& d) {
+        const auto& nodes = program_.dependents();
+        for (uint32_t k = d.first; k < d.first + d.count; ++k) {
+            mark(nodes[k]);
+        }
+    }
+
+    void mark(uint32_t index) {
+        dirty_[index] = 1;
+        marks_.push_back(index);
+    }
+
+    void markAll() {
+        const uint32_t n = static_cast<uint32_t>(dirty_.size());
+        std::fill(dirty_.begin(), dirty_.end(), 1);
+        marks_.resize(n);
+        for (uint32_t i = 0; i < n; ++i) marks_[i] = i;
+    }
+
+    long long earliestChange() const {
+        long long best = LLONG_MAX;
+        for (const uint32_t i : program_.timed()) {
+            const long long at = nextChange_[i];
+            if (at != LLONG_MIN && at < best) best = at;
+        }
+        return best;
+    }
+
+    // ------------------------------------------------------------
+    // Next change of a timed condition. A time.unix_ms operand must
+    // be args[0] and the strategy must predict it; any other token
+    // can only change the result when its own value ticks over.
+    // ------------------------------------------------------------
+    template<typename T>
+    long long predictChange(const Instr& in, const T* args) const {
+        const auto& ops = program_.operands();
+        const TimeContext& time = timeSource_.current();
+
+        long long next = LLONG_MAX;
+        for (uint32_t k = 0; k < in.argCount; ++k) {
+            const Operand& op = ops[in.firstArg + k];
+            if (op.kind != Operand::Kind::TIME) continue;
+
+            long long at = LLONG_MAX;
+            switch (op.time) {
+                case TimeToken::UNIX_MS: {
+                    T v{};
+                    if (k != 0 || !ConditionContext::nextChange(in.cond, args, in.argCount, v)) return LLONG_MIN;
+                    at = toUnixMs(v);
+                    break;
+                }
+                default:
+                    at = time.nextChange(op.time);
+                    break;
+            }
+            if (at < next) next = at;
+        }
+        return next;
+    }
+
+    template<typename T>
+    static long long toUnixMs(T v) {
+        if (v == std::numeric_limits<T>::max()) return LLONG_MAX;
+        if constexpr (std::is_floating_point_v<T>) {
+            const double c = std::ceil(v);
+            return c >= 9.2e18 ? LLONG_MAX : static_cast<long long>(c);
+        } else {
+            return static_cast<long long>(v);
+        }
+    }
+
+    // ------------------------------------------------------------
+    // Evaluate instrs [begin, end) in pre-order. A parent is always
+    // evaluated before its children; a range holds whole subtrees,
+    // except that the root's parent is evaluated before any range.
+    // Writes only its own nodes and out, so disjoint ranges can run
+    // concurrently.
+    // ------------------------------------------------------------
+    void run(uint32_t begin, uint32_t end, EvalOut& out,
+             const GH_GlobalState::GetterSnapshot& getters, uint64_t now) {
+        const auto& instrs = program_.instrs();
+        size_t cursor = static_cast<size_t>(
+            std::lower_bound(marks_.begin(), marks_.end(), begin) - marks_.begin());
+
+        for (uint32_t i = begin; i < end;) {
+            const Instr& in = instrs[i];
+            auto& rt = in.node->runtime();
+            const bool parentEffective = in.parent == RuleProgram::kNoParent ||
+                                         instrs[in.parent].node->runtime().effectiveResult;
+
+            while (cursor < marks_.size() && marks_[cursor] < i) ++cursor;
+            const bool marked = forceRefresh_ ||
+                                (cursor < marks_.size() && marks_[cursor] == i);
+
+            if (!marked && (parentEffective && rt.localResult) == rt.effectiveResult) {
+                const bool below = cursor < marks_.size() && marks_[cursor] < in.end;
+                i = below ? i + 1 : in.end;
+                continue;
+            }
+
+            evaluate(i, in, rt, parentEffective, out, getters, now);
+            ++i;
+        }
+    }
+
+    // ------------------------------------------------------------
+    // Segments: the root's subtrees grouped into contiguous runs of
+    // about size / (4 * threads) nodes, so fast threads pick up
+    // more of them. Empty when the tick stays single-threaded.
+    // ------------------------------------------------------------
+    void buildSegments() {
+        segments_.clear();
+
+        const auto& instrs = program_.instrs();
+        const uint32_t n = static_cast<uint32_t>(instrs.size());
+        if (!pool_ || n < parallelMin_ || n < 2) {
+            outs_.resize(1);
+            return;
+        }
+
+        const uint32_t target = std::max<uint32_t>(
+            1, static_cast<uint32_t>((n - 1) / (4 * (pool_->helpers() + 1))));
+
+        for (uint32_t i = 1; i < n;) {
+            const uint32_t first = i;
+            while (i < n && i - first < target) i = instrs[i].end;
+            segments_.emplace_back(first, i);
+        }
+
+        if (segments_.size() < 2) segments_.clear();
+        outs_.resize(segments_.size() + 1);
+    }
+
+    void evaluate(uint32_t index, const Instr& in, RuleRuntimeState& rt, bool parentEffective,
+                  EvalOut& out, const GH_GlobalState::GetterSnapshot& getters, uint64_t now) {
+        const bool evaluated = dirty_[index] != 0;
+        const auto started = profiling_ ? Clock::now() : Clock::time_point{};
 
-        auto& rt = node->runtime();
         rt.prevEffectiveResult = rt.effectiveResult;
-        rt.lastError.clear();
-        rt.resolvedArgs.clear();
-        rt.lastEvalMs = nowMs();
 
         try {
-            const auto resolved = resolver_.resolve(node->args());
-            rt.resolvedArgs = resolved;
-
-            rt.localResult = conditions_.check(node->condition(), resolved);
+            if (dirty_[index]) {
+                rt.lastError.clear();
+                rt.resolvedArgs.clear();
+                rt.lastEvalMs = now;
+                const bool r = checkCondition(index, in, rt, getters);
+                rt.localResult = rt.lastError.empty() ? dwell(index, in, rt, r) : r;
+            }
             rt.effectiveResult = parentEffective && rt.localResult;
 
-            processActions(*node);
+            processActions(index, in, rt, out);
 
         } catch (const std::exception& ex) {
             rt.localResult = false;
@@ -82,19 +502,149 @@ private:
             rt.lastError = "unknown logic error";
         }
 
-        for (auto& ch : node->children()) {
-            evaluateNode(ch.get(), node->runtime().effectiveResult);
+        // a failed node retries every tick, as it did with full passes
+        const bool failed = !rt.lastError.empty();
+        dirty_[index] = failed ? 1 : 0;
+        if (failed) nextChange_[index] = LLONG_MIN;
+
+        if (failed || in.everyTick || rt.effectiveResult != rt.prevEffectiveResult) {
+            out.nextMarks.push_back(index);
+        }
+
+        if (profiling_) {
+            // each index belongs to one range, so segments never share a counter
+            NodeProfile& p = profile_[index];
+            const uint64_t ns = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count());
+            ++p.visits;
+            p.totalNs += ns;
+            if (ns > p.maxNs) p.maxNs = ns;
+            if (evaluated) {
+                ++p.evals;
+                ++(rt.localResult ? p.trueCount : p.falseCount);
+            }
+        }
+    }
+
+    // ------------------------------------------------------------
+    // Condition: operands are read in the condition's own type
+    // ------------------------------------------------------------
+    bool checkCondition(uint32_t index, const Instr& in, RuleRuntimeState& rt,
+                        const GH_GlobalState::GetterSnapshot& getters) {
+        if (in.expr != RuleProgram::kNoExpr) return checkExpression(index, in, rt, getters);
+
+        if (!in.cond.valid()) {
+            rt.lastError = in.node->condition() == "expr"
+                ? "Invalid expression (see log)"
+                : "Condition not found: " + in.node->condition();
+            return false;
+        }
+
+        switch (in.cond.type) {
+            case CondType::F64:  return checkTyped<double>(index, in, rt, getters);
+            case CondType::I64:  return checkTyped<long long>(index, in, rt, getters);
+            case CondType::BOOL: return checkTyped<bool>(index, in, rt, getters);
+        }
+        return false;
+    }
+
+    // operands stay on the stack; nothing here allocates
+    template<typename T>
+    bool checkTyped(uint32_t index, const Instr& in, RuleRuntimeState& rt,
+                    const GH_GlobalState::GetterSnapshot& getters) {
+        T args[kMaxCondArgs]{};
+
+        const auto& ops = program_.operands();
+        for (uint32_t k = 0; k < in.argCount; ++k) {
+            const Operand& op = ops[in.firstArg + k];
+
+            T v{};
+            if (!ArgumentResolver::read(op, getters, timeSource_.current(), v)) {
+                rt.lastError = "Invalid argument for " + in.node->condition() + ": " + op.token;
+                return false;
+            }
+
+            if (k < kMaxCondArgs) args[k] = v;
+            rt.resolvedArgs.push_back(toArgValue(v));
+        }
+
+        if constexpr (std::is_same_v<T, double>) {
+            if (in.cond.temporal) {
+                long long next = LLONG_MAX;
+                const bool r = ConditionContext::evaluate(in.cond, args, in.argCount, rt.temporal,
+                                                          timeSource_.current().unixMs, next);
+                nextChange_[index] = earlier(predictChange(in, args), next);
+                return r;
+            }
         }
+
+        if (in.timed) nextChange_[index] = predictChange(in, args);
+        return ConditionContext::evaluate(in.cond, args, in.argCount);
     }
 
-    void processActions(RuleNode& node) {
-        auto& rt = node.runtime();
+    // operands read as double; time.unix_ms makes the node per-tick
+    bool checkExpression(uint32_t index, const Instr& in, RuleRuntimeState& rt,
+                         const GH_GlobalState::GetterSnapshot& getters) {
+        double vars[kMaxExprOperands]{};
+
+        const auto& ops = program_.operands();
+        for (uint32_t k = 0; k < in.argCount; ++k) {
+            const Operand& op = ops[in.firstArg + k];
+            if (!ArgumentResolver::read(op, getters, timeSource_.current(), vars[k])) {
+                rt.lastError = "Invalid operand in expression: " + op.token;
+                return false;
+            }
+            rt.resolvedArgs.push_back(ArgValue::f64(vars[k]));
+        }
 
+        if (in.timed) nextChange_[index] = predictChange(in, vars);
+        return program_.expressions()[in.expr].test(vars);
+    }
+
+    // ------------------------------------------------------------
+    // Dwell: a new result is held back until the current one has
+    // lasted minOnMs (true) or minOffMs (false); the node is woken
+    // when the hold ends. nextChange_ was just set by checkTyped.
+    // ------------------------------------------------------------
+    bool dwell(uint32_t index, const Instr& in, RuleRuntimeState& rt, bool r) {
+        if (in.minOnMs == 0 && in.minOffMs == 0) return r;
+
+        TemporalState& st = rt.temporal;
+        const long long now = timeSource_.current().unixMs;
+        if (st.changedMs > now) st.changedMs = now;   // clock stepped back
+
+        if (r == rt.localResult) return r;
+
+        const long long hold = rt.localResult ? in.minOnMs : in.minOffMs;
+        if (st.changedMs != LLONG_MIN && now - st.changedMs < hold) {
+            nextChange_[index] = earlier(nextChange_[index], st.changedMs + hold);
+            return rt.localResult;
+        }
+
+        st.changedMs = now;
+        return r;
+    }
+
+    // LLONG_MIN (every tick) wins, otherwise the sooner one
+    static long long earlier(long long a, long long b) {
+        if (a == LLONG_MIN || b == LLONG_MIN) return LLONG_MIN;
+        return std::min(a, b);
+    }
+
+    static ArgValue toArgValue(double v)    { return ArgValue::f64(v); }
+    static ArgValue toArgValue(long long v) { return ArgValue::i64(v); }
+    static ArgValue toArgValue(bool v)      { return ArgValue::boolean(v); }
+
+    // ------------------------------------------------------------
+    // Actions
+    // ------------------------------------------------------------
+    void processActions(uint32_t index, const Instr& in, RuleRuntimeState& rt, EvalOut& out) {
         const bool entered = (!rt.prevEffectiveResult && rt.effectiveResult);
         const bool exited  = (rt.prevEffectiveResult && !rt.effectiveResult);
 
-        for (const auto& action : node.actions()) {
-            if (!action.enabled) continue;
+        const auto& actions = program_.actions();
+        for (uint32_t k = 0; k < in.actionCount; ++k) {
+            const CompiledAction& action = actions[in.firstAction + k];
 
             bool shouldFire = false;
 
@@ -118,78 +668,85 @@ private:
 
             if (!shouldFire) continue;
 
-            applyAction(action);
+            fire(index, action, out);
             rt.lastFireMs = nowMs();
         }
     }
 
-    void applyAction(const ActionModel& action) {
-        const int id = gs_.execIdByName(action.target);
-
-        // --------------------------------------------------------
-        // IMPORTANT:
-        // If executor is in MANUAL mode, logic must not overwrite it.
-        // --------------------------------------------------------
-        {
-            const auto actual = gs_.getExecActualEntry(id);
-            const auto desired = gs_.getExecDesiredEntry(id);
-
-            if (actual.mode == GH_MODE::MANUAL || desired.mode == GH_MODE::MANUAL) {
-                return;
-            }
+    void fire(uint32_t index, const CompiledAction& action, EvalOut& out) {
+        if (!action.error.empty()) {
+            throw std::runtime_error(action.error);
         }
 
-        switch (action.valueType) {
-            case ActionValueType::BOOL: {
-                const bool v = parseBool(action.value);
-                gs_.setExecDesired(id, v, GH_MODE::AUTO, "logic", true);
-                return;
-            }
-
-            case ActionValueType::INT: {
-                const int v = parseInt(action.value);
-                gs_.setExecDesired(id, v, GH_MODE::AUTO, "logic", true);
-                return;
-            }
-
-            case ActionValueType::DOUBLE: {
-                const double v = parseDouble(action.value);
-                gs_.setExecDesired(id, v, GH_MODE::AUTO, "logic", true);
-                return;
-            }
+        // executor registered after the program was compiled
+        const auto h = action.exec.valid() ? action.exec : gs_.execHandleByName(action.target);
+        out.fired.push_back(Fired{h, &action, index});
+    }
 
-            case ActionValueType::STRING: {
-                gs_.setExecDesired(id, action.value, GH_MODE::AUTO, "logic", true);
-                return;
-            }
+    // ------------------------------------------------------------
+    // Arbitration: per target the highest priority wins; on a tie
+    // the later action in pre-order wins, as it did when every
+    // action was written on its own.
+    // ------------------------------------------------------------
+    void stage(const Fired& f) {
+        ++commit_.fired;
+        if (profiling_) ++profile_[f.node].fires;
+        if (f.exec.slot >= stagedBySlot_.size()) stagedBySlot_.resize(f.exec.slot + 1, kNotStaged);
+
+        uint32_t& at = stagedBySlot_[f.exec.slot];
+        if (at == kNotStaged) {
+            at = static_cast<uint32_t>(staged_.size());
+            staged_.push_back(f.action);
+            stagedNode_.push_back(f.node);
+            writes_.push_back(GH_GlobalState::ExecDesiredWrite{f.exec, {}});
+            return;
         }
 
-        throw std::runtime_error("Unsupported ActionValueType");
+        ++commit_.overridden;
+        uint32_t loser = f.node;
+        if (f.action->priority >= staged_[at]->priority) {
+            loser = stagedNode_[at];
+            staged_[at] = f.action;
+            stagedNode_[at] = f.node;
+        }
+        if (profiling_) ++profile_[loser].overridden;
     }
 
-    static bool parseBool(const std::string& s) {
-        if (s == "true" || s == "1" || s == "TRUE") return true;
-        if (s == "false" || s == "0" || s == "FALSE") return false;
-        throw std::runtime_error("Invalid bool literal: " + s);
-    }
+    // ------------------------------------------------------------
+    // One batched write for the whole tick. MANUAL executors and
+    // unchanged values are filtered under the same lock (see
+    // GH_GlobalState::commitExecDesired), so the bridge is only
+    // woken for real changes.
+    // ------------------------------------------------------------
+    void commitWrites() {
+        for (const auto& out : outs_) {
+            for (const auto& f : out.fired) stage(f);
+        }
+        if (staged_.empty()) return;
 
-    static int parseInt(const std::string& s) {
-        size_t pos = 0;
-        const int v = std::stoi(s, &pos);
-        if (pos != s.size()) {
-            throw std::runtime_error("Invalid int literal: " + s);
+        for (size_t k = 0; k < staged_.size(); ++k) {
+            writes_[k].value = staged_[k]->value;
+            stagedBySlot_[writes_[k].handle.slot] = kNotStaged;
         }
-        return v;
-    }
+        commit_.staged = static_cast<uint32_t>(staged_.size());
 
-    static double parseDouble(const std::string& s) {
-        size_t pos = 0;
-        const double v = std::stod(s, &pos);
-        if (pos != s.size()) {
-            throw std::runtime_error("Invalid double literal: " + s);
+        try {
+            commit_.written = static_cast<uint32_t>(
+                gs_.commitExecDesired(writes_, "logic", profiling_ ? &applied_ : nullptr));
+
+            if (profiling_) {
+                for (size_t k = 0; k < staged_.size(); ++k) {
+                    if (!applied_[k]) ++profile_[stagedNode_[k]].unchanged;
+                }
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << "[LOGIC] commit failed: " << ex.what() << "\n";
         }
-        return v;
+
+        staged_.clear();
+        stagedNode_.clear();
+        writes_.clear();
     }
 };
 
-} // namespace logic
\ No newline at end of file
+} // namespace logic
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <climits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -9,6 +10,39 @@
 
 namespace logic {
 
+// ------------------------------------------------------------
+// One condition operand as last evaluated, already converted to
+// the condition's type (formatted only when the web asks for it)
+// ------------------------------------------------------------
+struct ArgValue {
+    enum class Type : uint8_t { F64, I64, BOOL };
+
+    Type type{Type::F64};
+    union {
+        double    d;
+        long long i;
+        bool      b;
+    };
+
+    ArgValue() : d(0.0) {}
+
+    static ArgValue f64(double v)    { ArgValue a; a.type = Type::F64;  a.d = v; return a; }
+    static ArgValue i64(long long v) { ArgValue a; a.type = Type::I64;  a.i = v; return a; }
+    static ArgValue boolean(bool v)  { ArgValue a; a.type = Type::BOOL; a.b = v; return a; }
+};
+
+// ------------------------------------------------------------
+// Memory of temporal conditions and dwell times. Only the last
+// reference point is kept, never a history, so every update is O(1).
+// ------------------------------------------------------------
+struct TemporalState {
+    bool      result{false};          // held inside a band or between windows
+    long long sinceMs{LLONG_MIN};     // in_range_for: entered the range, LLONG_MIN = outside
+    double    refValue{0.0};          // rising / falling / delta_*: reference sample
+    long long refMs{LLONG_MIN};       // LLONG_MIN = no sample yet
+    long long changedMs{LLONG_MIN};   // dwell: last change of localResult
+};
+
 // ------------------------------------------------------------
 // Runtime state for debugging and web
 // ------------------------------------------------------------
@@ -21,7 +55,9 @@ struct RuleRuntimeState {
     uint64_t lastFireMs{0};
 
     std::string lastError;
-    std::vector<std::string> resolvedArgs;
+    std::vector<ArgValue> resolvedArgs;   // capacity reserved at compile time
+
+    TemporalState temporal;
 };
 
 // ------------------------------------------------------------
@@ -54,6 +90,10 @@ public:
     const std::vector<Ptr>& children() const { return children_; }
     std::vector<Ptr>& children() { return children_; }
 
+    // optional stable id, matches the node across reloads
+    const std::string& id() const { return id_; }
+    void setId(std::string id) { id_ = std::move(id); }
+
     const std::string& title() const { return title_; }
     const std::string& condition() const { return condition_; }
     const std::vector<std::string>& args() const { return args_; }
@@ -62,14 +102,31 @@ public:
     std::vector<std::string>& args() { return args_; }
     std::vector<ActionModel>& actions() { return actions_; }
 
+    // dwell: minimum time localResult stays true / false, 0 = none
+    long long minOnMs() const { return minOnMs_; }
+    long long minOffMs() const { return minOffMs_; }
+    void setDwell(long long minOnMs, long long minOffMs) {
+        minOnMs_ = minOnMs;
+        minOffMs_ = minOffMs;
+    }
+
+    // same condition, args, actions and dwell (children not compared)
+    bool sameDefinition(const RuleNode& o) const {
+        return condition_ == o.condition_ && args_ == o.args_ && actions_ == o.actions_ &&
+               minOnMs_ == o.minOnMs_ && minOffMs_ == o.minOffMs_;
+    }
+
     RuleRuntimeState& runtime() { return runtime_; }
     const RuleRuntimeState& runtime() const { return runtime_; }
 
 private:
+    std::string id_;
     std::string title_;
     std::string condition_;
     std::vector<std::string> args_;
     std::vector<ActionModel> actions_;
+    long long minOnMs_{0};
+    long long minOffMs_{0};
 
     std::vector<Ptr> children_;
     RuleNode* parent_{nullptr};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../GlobalState.hpp"
+#include "RuleTree.hpp"
+#include "RuleNode.hpp"
+#include "ActionModel.hpp"
+#include "ConditionContext.hpp"
+#include "ArgumentResolver.hpp"
+#include "Expression.hpp"
+
+namespace logic {
+
+// ------------------------------------------------------------
+// Enabled action with its value already parsed.
+// A bad value literal is kept as error and thrown when the
+// action fires, the same point the old engine failed at.
+// ------------------------------------------------------------
+struct CompiledAction {
+    GH_GlobalState::ExecHandle exec{};   // invalid: looked up by name when fired
+    std::string target;
+    GH_GlobalState::Value value;
+    TriggerMode trigger{TriggerMode::ON_ENTER};
+    int priority{0};
+    std::string error;
+};
+
+// ------------------------------------------------------------
+// One rule node. Instructions are in pre-order, so a parent
+// always comes before its children and [index, end) is the
+// node's whole subtree.
+// ------------------------------------------------------------
+struct Instr {
+    RuleNode* node{nullptr};   // runtime state stays on the node
+    uint32_t  parent{0};
+    uint32_t  end{0};
+    CondRef   cond{};
+    uint32_t  firstArg{0};
+    uint32_t  argCount{0};
+    uint32_t  firstAction{0};
+    uint32_t  actionCount{0};
+    bool      everyTick{false};   // has a WHILE_* action
+    bool      timed{false};       // reads a time token, is temporal or has a dwell
+    long long minOnMs{0};         // dwell, see RuleNode::minOnMs()
+    long long minOffMs{0};
+    uint32_t  expr{0xFFFFFFFFu};  // "expr" condition: index into expressions()
+};
+
+// ------------------------------------------------------------
+// Nodes whose condition reads one input (getter slot or time
+// token): dependents()[first, first + count), ascending.
+// ------------------------------------------------------------
+struct Dependency {
+    uint32_t key{0};
+    uint32_t first{0};
+    uint32_t count{0};
+};
+
+// ------------------------------------------------------------
+// RuleTree flattened for RuleEngine::tick().
+// Built from a tree and points into it: recompile whenever the
+// tree is replaced.
+// ------------------------------------------------------------
+class RuleProgram {
+public:
+    static constexpr uint32_t kNoParent = 0xFFFFFFFFu;
+    static constexpr uint32_t kNoExpr = 0xFFFFFFFFu;
+
+    static RuleProgram compile(RuleTree& tree,
+                               const GH_GlobalState& gs,
+                               const ConditionContext& conditions) {
+        RuleProgram p;
+        const ArgumentResolver resolver(gs);
+        Uses getterUses;
+        Uses timeUses;
+        if (tree.root()) {
+            p.compileNode(tree.root(), kNoParent, gs, resolver, conditions, getterUses, timeUses);
+        }
+        p.buildIndex(getterUses, p.getterDeps_);
+        p.buildIndex(timeUses, p.timeDeps_);
+        return p;
+    }
+
+    bool empty() const { return instrs_.empty(); }
+    size_t size() const { return instrs_.size(); }
+
+    const std::vector<Instr>& instrs() const { return instrs_; }
+    const std::vector<Operand>& operands() const { return operands_; }
+    const std::vector<CompiledAction>& actions() const { return actions_; }
+    const std::vector<Expression>& expressions() const { return expressions_; }
+
+    // dependency index for incremental evaluation
+    const std::vector<Dependency>& getterDeps() const { return getterDeps_; }
+    const std::vector<Dependency>& timeDeps() const { return timeDeps_; }
+    const std::vector<uint32_t>& dependents() const { return dependents_; }
+    const std::vector<uint32_t>& timed() const { return timed_; }
+
+    static bool parseBool(const std::string& s) {
+        if (s == "true" || s == "1" || s == "TRUE") return true;
+        if (s == "false" || s == "0" || s == "FALSE") return false;
+        throw std::runtime_error("Invalid bool literal: " + s);
+    }
+
+    static int parseInt(const std::string& s) {
+        size_t pos = 0;
+        const int v = std::stoi(s, &pos);
+        if (pos != s.size()) {
+            throw std::runtime_error("Invalid int literal: " + s);
+        }
+        return v;
+    }
+
+    static double parseDouble(const std::string& s) {
+        size_t pos = 0;
+        const double v = std::stod(s, &pos);
+        if (pos != s.size()) {
+            throw std::runtime_error("Invalid double literal: " + s);
+        }
+        return v;
+    }
+
+private:
+    std::vector<Instr>          instrs_;
+    std::vector<Operand>        operands_;
+    std::vector<CompiledAction> actions_;
+    std::vector<Expression>     expressions_;
+    std::vector<Dependency>     getterDeps_;
+    std::vector<Dependency>     timeDeps_;
+    std::vector<uint32_t>       dependents_;
+    std::vector<uint32_t>       timed_;        // instrs with Instr::timed, ascending
+
+    // (input key, instr index)
+    using Uses = std::vector<std::pair<uint32_t, uint32_t>>;
+
+    void compileNode(RuleNode* node,
+                     uint32_t parent,
+                     const GH_GlobalState& gs,
+                     const ArgumentResolver& resolver,
+                     const ConditionContext& conditions,
+                     Uses& getterUses,
+                     Uses& timeUses) {
+        const uint32_t index = static_cast<uint32_t>(instrs_.size());
+
+        Instr in;
+        in.node = node;
+        in.parent = parent;
+
+        // an expression binds its identifiers instead of the args
+        const std::vector<std::string>* tokens = &node->args();
+
+        if (node->condition() == "expr") {
+            in.expr = compileExpression(node);
+            if (in.expr != kNoExpr) tokens = &expressions_[in.expr].names();
+        } else if (!conditions.find(node->condition(), in.cond)) {
+            std::cerr << "[LOGIC] Condition not found: " << node->condition()
+                      << " (rule '" << node->title() << "')\n";
+        }
+
+        in.firstArg = static_cast<uint32_t>(operands_.size());
+        for (const auto& a : *tokens) {
+            const Operand op = resolver.bind(a, in.cond.type);
+            if (op.kind == Operand::Kind::GETTER) getterUses.emplace_back(op.getter.slot, index);
+            if (op.kind == Operand::Kind::TIME) {
+                timeUses.emplace_back(static_cast<uint32_t>(op.time), index);
+                in.timed = true;
+            }
+            operands_.push_back(op);
+        }
+        in.argCount = static_cast<uint32_t>(operands_.size()) - in.firstArg;
+
+        in.firstAction = static_cast<uint32_t>(actions_.size());
+        for (const auto& a : node->actions()) {
+            if (!a.enabled) continue;
+            actions_.push_back(compileAction(a, gs));
+            in.everyTick = in.everyTick ||
+                           a.trigger == TriggerMode::WHILE_TRUE ||
+                           a.trigger == TriggerMode::WHILE_FALSE;
+        }
+        in.actionCount = static_cast<uint32_t>(actions_.size()) - in.firstAction;
+
+        node->runtime().resolvedArgs.reserve(in.argCount);
+
+        // results that can change with the clock alone are woken by it
+        in.minOnMs = std::max(0LL, node->minOnMs());
+        in.minOffMs = std::max(0LL, node->minOffMs());
+        if (in.cond.temporal || in.minOnMs > 0 || in.minOffMs > 0) in.timed = true;
+
+        if (in.timed) timed_.push_back(index);
+
+        instrs_.push_back(in);
+        for (auto& ch : node->children()) {
+            compileNode(ch.get(), index, gs, resolver, conditions, getterUses, timeUses);
+        }
+        instrs_[index].end = static_cast<uint32_t>(instrs_.size());
+    }
+
+    // kNoExpr when the args are not exactly one valid expression
+    uint32_t compileExpression(const RuleNode* node) {
+        std::string error = "expects one arg";
+        Expression e;
+        if (node->args().size() == 1 && Expression::compile(node->args()[0], e, error)) {
+            expressions_.push_back(std::move(e));
+            return static_cast<uint32_t>(expressions_.size() - 1);
+        }
+
+        std::cerr << "[LOGIC] Expression error: " << error
+                  << " (rule '" << node->title() << "')\n";
+        return kNoExpr;
+    }
+
+    void buildIndex(Uses& uses, std::vector<Dependency>& out) {
+        std::sort(uses.begin(), uses.end());
+        uses.erase(std::unique(uses.begin(), uses.end()), uses.end());
+
+        for (const auto& u : uses) {
+            if (out.empty() || out.back().key != u.first) {
+                out.push_back(Dependency{u.first, static_cast<uint32_t>(dependents_.size()), 0});
+            }
+            dependents_.push_back(u.second);
+            ++out.back().count;
+        }
+    }
+
+    static CompiledAction compileAction(const ActionModel& a, const GH_GlobalState& gs) {
+        using Value = GH_GlobalState::Value;
+
+        CompiledAction c;
+        c.target = a.target;
+        c.trigger = a.trigger;
+        c.priority = a.priority;
+        (void)gs.findExecHandle(a.target, c.exec);
+
+        try {
+            switch (a.valueType) {
+                case ActionValueType::BOOL:   c.value = Value::of(parseBool(a.value));   break;
+                case ActionValueType::INT:    c.value = Value::of(parseInt(a.value));    break;
+                case ActionValueType::DOUBLE: c.value = Value::of(parseDouble(a.value)); break;
+                case ActionValueType::STRING: c.value = Value::of(a.value);              break;
+            }
+        } catch (const std::exception& ex) {
+            c.error = ex.what();
+        }
+
+        return c;
+    }
+};
+
+} // namespace logic
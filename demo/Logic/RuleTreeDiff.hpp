@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "RuleTree.hpp"
+#include "RuleNode.hpp"
+
+namespace logic {
+
+// ------------------------------------------------------------
+// Structural diff between the running tree and a reloaded one.
+//
+// Nodes are matched top-down among siblings of matched parents:
+// by "id" when the node has one, otherwise by title and its
+// occurrence among same-titled siblings. A matched node with the
+// same condition, args and actions keeps its runtime state; an
+// edited or new node starts fresh. Children of an edited node are
+// still matched on their own.
+// ------------------------------------------------------------
+class RuleTreeDiff {
+public:
+    size_t kept{0};      // matched and unchanged
+    size_t changed{0};   // matched, definition edited
+    size_t added{0};     // no counterpart in the old tree
+    size_t removed{0};   // old nodes without a counterpart
+
+    // Only reads the structure of from; the runtime state is
+    // copied later by carryRuntime().
+    static RuleTreeDiff compute(const RuleTree& from, RuleTree& to) {
+        RuleTreeDiff d;
+
+        const size_t oldCount = from.levelOrder().size();
+        if (to.root()) {
+            if (from.root() && key(*from.root(), 0) == key(*to.root(), 0)) {
+                d.match(*from.root(), *to.root());
+            } else {
+                d.added += countNodes(*to.root());
+            }
+        }
+        d.removed = oldCount - d.kept - d.changed;
+        return d;
+    }
+
+    // Copies the matched runtime states. Call with the engine
+    // stopped (under the tick mutex) and before from changes.
+    void carryRuntime() const {
+        for (const auto& [from, to] : pairs_) {
+            to->runtime() = from->runtime();
+        }
+    }
+
+private:
+    std::vector<std::pair<const RuleNode*, RuleNode*>> pairs_;
+
+    static std::string key(const RuleNode& n, size_t occurrence) {
+        if (!n.id().empty()) return "#" + n.id();
+        return n.title() + "/" + std::to_string(occurrence);
+    }
+
+    static size_t countNodes(const RuleNode& n) {
+        size_t c = 1;
+        for (const auto& ch : n.children()) c += countNodes(*ch);
+        return c;
+    }
+
+    // fills keys with one key per child, in order
+    static void childKeys(const RuleNode& n, std::vector<std::string>& keys) {
+        std::unordered_map<std::string, size_t> seen;
+        keys.clear();
+        for (const auto& ch : n.children()) {
+            const size_t occ = ch->id().empty() ? seen[ch->title()]++ : 0;
+            keys.push_back(key(*ch, occ));
+        }
+    }
+
+    void match(const RuleNode& from, RuleNode& to) {
+        if (from.sameDefinition(to)) {
+            ++kept;
+            pairs_.emplace_back(&from, &to);
+        } else {
+            ++changed;
+        }
+
+        std::vector<std::string> keys;
+        childKeys(from, keys);
+
+        std::unordered_map<std::string, const RuleNode*> old;
+        old.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            old.emplace(keys[i], from.children()[i].get());   // duplicate ids: first wins
+        }
+
+        childKeys(to, keys);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            RuleNode& ch = *to.children()[i];
+
+            auto it = old.find(keys[i]);
+            if (it == old.end() || !it->second) {
+                added += countNodes(ch);
+                continue;
+            }
+
+            const RuleNode* prev = it->second;
+            it->second = nullptr;   // matched at most once
+            match(*prev, ch);
+        }
+    }
+};
+
+} // namespace logic
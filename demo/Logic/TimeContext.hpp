@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../Tools/DateTime.hpp"
+
+namespace logic {
+
+// ------------------------------------------------------------
+// Time helper tokens usable as rule args
+// ------------------------------------------------------------
+enum class TimeToken : uint8_t {
+    UNIX_MS,
+    HOUR,
+    MINUTE,
+    SECOND,
+    DAILY_HHMMSS,
+    SECONDS_OF_DAY,
+    YEAR,
+    MONTH,
+    DAY,
+    DAY_OF_YEAR
+};
+
+constexpr size_t kTimeTokenCount = 10;
+
+// ------------------------------------------------------------
+// One instant as every rule of a tick sees it: unix ms and its
+// local-time breakdown. Built once per tick by TimeSource.
+// ------------------------------------------------------------
+struct TimeContext {
+    long long unixMs{0};
+
+    int year{0};
+    int month{0};
+    int day{0};
+    int hour{0};
+    int minute{0};
+    int second{0};
+    int millisecond{0};
+
+    int secondsOfDay{0};   // local hh:mm:ss in seconds, 0..86399
+    int dayOfYear{0};      // 1..366
+
+    long long value(TimeToken t) const {
+        switch (t) {
+            case TimeToken::UNIX_MS:        return unixMs;
+            case TimeToken::HOUR:           return hour;
+            case TimeToken::MINUTE:         return minute;
+            case TimeToken::SECOND:         return second;
+            case TimeToken::DAILY_HHMMSS:   return hour * 10000LL + minute * 100LL + second;
+            case TimeToken::SECONDS_OF_DAY: return secondsOfDay;
+            case TimeToken::YEAR:           return year;
+            case TimeToken::MONTH:          return month;
+            case TimeToken::DAY:            return day;
+            case TimeToken::DAY_OF_YEAR:    return dayOfYear;
+        }
+        return unixMs;
+    }
+
+    // ------------------------------------------------------------
+    // Unix ms of the next instant the token's value can change.
+    // Date tokens are re-checked hourly: a local midnight moves
+    // with DST, a local hour boundary does not.
+    // ------------------------------------------------------------
+    long long nextChange(TimeToken t) const {
+        const long long secondStart = unixMs - millisecond;
+
+        switch (t) {
+            case TimeToken::UNIX_MS:
+                return unixMs + 1;
+
+            case TimeToken::SECOND:
+            case TimeToken::DAILY_HHMMSS:
+            case TimeToken::SECONDS_OF_DAY:
+                return secondStart + 1000;
+
+            case TimeToken::MINUTE:
+                return secondStart - second * 1000LL + 60000;
+
+            case TimeToken::HOUR:
+            case TimeToken::YEAR:
+            case TimeToken::MONTH:
+            case TimeToken::DAY:
+            case TimeToken::DAY_OF_YEAR:
+                return secondStart - (minute * 60LL + second) * 1000 + 3600000;
+        }
+        return unixMs + 1;
+    }
+};
+
+// ------------------------------------------------------------
+// Builds the TimeContext of each tick. The timezone conversion
+// (localtime_r) runs only when the second changes; within the
+// same second only the milliseconds move.
+// ------------------------------------------------------------
+class TimeSource {
+public:
+    const TimeContext& sample() {
+        return at(tools::nowUnixMs());
+    }
+
+    const TimeContext& at(long long unixMs) {
+        long long sec = unixMs / 1000;
+        if (unixMs % 1000 < 0) --sec;
+
+        if (!cached_ || sec != cachedSec_) {
+            const auto dt = tools::fromUnixMs(sec * 1000);
+            ctx_.year   = dt.year;
+            ctx_.month  = dt.month;
+            ctx_.day    = dt.day;
+            ctx_.hour   = dt.hour;
+            ctx_.minute = dt.minute;
+            ctx_.second = dt.second;
+            ctx_.secondsOfDay = dt.hour * 3600 + dt.minute * 60 + dt.second;
+            ctx_.dayOfYear    = dt.dayOfYear;
+
+            cachedSec_ = sec;
+            cached_ = true;
+        }
+
+        ctx_.unixMs = unixMs;
+        ctx_.millisecond = static_cast<int>(unixMs - sec * 1000);
+        return ctx_;
+    }
+
+    const TimeContext& current() const { return ctx_; }
+
+private:
+    TimeContext ctx_;
+    long long cachedSec_{0};
+    bool cached_{false};
+};
+
+} // namespace logic
@@ -1,20 +1,37 @@
 #pragma once
-#include <boost/asio/thread_pool.hpp>
-#include <boost/asio/post.hpp>
+#include "../Tools/LogLinearHistogram.hpp"
+#include "../Tools/VirtualClock.hpp"
+#include "TaskGraph.hpp"
+#include "WorkerLane.hpp"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
+// ------------------------------------------------------------
+// Timing wheel geometry: GH_SCHED_WHEEL_LEVELS levels of
+// 2^GH_SCHED_WHEEL_BITS slots, 1 ms per level-0 slot.
+// Defaults (4 x 256) cover 2^32 ms (~49 days) before a timer is
+// parked in the top level and re-cascaded.
+// ------------------------------------------------------------
+#ifndef GH_SCHED_WHEEL_BITS
+#define GH_SCHED_WHEEL_BITS 8
+#endif
+
+#ifndef GH_SCHED_WHEEL_LEVELS
+#define GH_SCHED_WHEEL_LEVELS 4
+#endif
+
 class Scheduler final {
 public:
     using Clock     = std::chrono::steady_clock;
@@ -22,6 +39,31 @@ public:
     using Ms        = std::chrono::milliseconds;
     using Fn        = std::function<void()>;
     using TaskId    = std::uint64_t;
+    using LaneId    = ::LaneId;
+
+    // Lane 0 is the pool given to instance(); addLane() adds more.
+    static constexpr LaneId kDefaultLane = 0;
+
+    // How a periodic task is rescheduled after it fires.
+    //   FIXED_DELAY          next = fire time + period (drifts by dispatch latency)
+    //   FIXED_RATE_CATCH_UP  next = previous due + period, missed fires run back to back
+    //   FIXED_RATE_SKIP      next = previous due + period, missed fires are dropped
+    //                        (stays on the original phase grid)
+    enum class Periodic : std::uint8_t {
+        FIXED_DELAY,
+        FIXED_RATE_CATCH_UP,
+        FIXED_RATE_SKIP
+    };
+
+    // noOverlap: a fire that comes due while the previous run is still
+    // executing is not posted; all such fires coalesce into one run
+    // started as soon as the current run returns.
+    // lane: worker lane the task runs on.
+    struct PeriodicPolicy {
+        Periodic mode{Periodic::FIXED_DELAY};
+        bool     noOverlap{false};
+        LaneId   lane{kDefaultLane};
+    };
 
     struct TaskInfo {
         TaskId     id;
@@ -29,11 +71,23 @@ public:
         bool       periodic;
         long long  msUntilRun;
         long long  periodMs;
+        long long  overruns;       // fires dropped (skipped, or merged into a coalesced run)
     };
     struct RunningInfo {
         TaskId      id;
         std::string name;
         int         workerIndex;   // стабильный индекс потока (W0, W1, ...)
+        std::string lane;
+    };
+
+    // Per task name, since the first run (or resetTaskStats()).
+    // lateUs: actual start minus planned fire time; runUs: fn() duration.
+    using Histogram = tools::LogLinearHistogram;
+    struct TaskStats {
+        std::string        name;
+        std::uint64_t      overruns;
+        Histogram::Summary lateUs;
+        Histogram::Summary runUs;
     };
 
     static Scheduler& instance(std::size_t poolThreads = std::thread::hardware_concurrency()) {
@@ -41,16 +95,125 @@ public:
         return inst;
     }
 
+    // Adds a named lane with its own threads, so tasks on it never
+    // queue behind blocking work on another lane. Throws on a
+    // duplicate name or after stop().
+    LaneId addLane(LaneConfig cfg) {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (stopped_) throw std::runtime_error("Scheduler::addLane: stopped");
+        for (const auto& l : lanes_) {
+            if (l->config().name == cfg.name) {
+                throw std::runtime_error("Scheduler::addLane: duplicate lane " + cfg.name);
+            }
+        }
+        lanes_.push_back(std::make_unique<WorkerLane>(std::move(cfg)));
+        return static_cast<LaneId>(lanes_.size() - 1);
+    }
+
     TaskId addDelayed(Fn fn, Ms delay, std::string name = "") {
-        return addTask(std::move(fn), Clock::now() + delay, Ms::zero(), false, std::move(name));
+        return addDelayed(std::move(fn), delay, std::move(name), kDefaultLane);
+    }
+    TaskId addDelayed(Fn fn, Ms delay, std::string name, LaneId lane) {
+        PeriodicPolicy policy;
+        policy.lane = lane;
+        return addTask(std::move(fn), now() + delay, Ms::zero(), false, std::move(name), policy);
     }
     TaskId addPeriodic(Fn fn, Ms period, std::string name = "") {
+        return addPeriodic(std::move(fn), period, std::move(name), PeriodicPolicy{});
+    }
+    TaskId addPeriodic(Fn fn, Ms period, std::string name, PeriodicPolicy policy) {
         if (period.count() <= 0) period = Ms(1);
-        return addTask(std::move(fn), Clock::now() + period, period, true, std::move(name));
+        return addTask(std::move(fn), now() + period, period, true, std::move(name), policy);
+    }
+    // Runs a TaskGraph as one periodic cycle. The cycle is a single
+    // task as far as policy, cancel() and trigger() are concerned and
+    // never overlaps itself. Stage stats appear as "<name>/<stage>";
+    // there, overruns count cycles in which the stage returned after
+    // its deadline. Stages run on policy.lane unless set with
+    // TaskGraph::runOn().
+    TaskId addGraph(TaskGraph graph, Ms period, std::string name) {
+        return addGraph(std::move(graph), period, std::move(name), PeriodicPolicy{});
     }
+    TaskId addGraph(TaskGraph graph, Ms period, std::string name, PeriodicPolicy policy) {
+        graph.validate();
+        if (period.count() <= 0) period = Ms(1);
+        policy.noOverlap = true;
+
+        auto g = std::make_unique<GraphRun>(std::move(graph));
+        return addTask(nullptr, now() + period, period, true, std::move(name), policy, std::move(g));
+    }
+
+    // ------------------------------------------------------------
+    // Simulated time. Must be called before the first task is added.
+    // Enables tools::VirtualClock at startUnixMs; from then on the
+    // dispatcher does not sleep: once every posted run (and graph
+    // stage) has returned it jumps the clock straight to the next
+    // due tick. A week of 100 ms cycles runs as fast as the tasks
+    // themselves. A task that never returns stops simulated time.
+    // ------------------------------------------------------------
+    void useVirtualClock(long long startUnixMs) {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (stopped_ || !tasks_.empty()) {
+                throw std::runtime_error("Scheduler::useVirtualClock: must be called before any task is added");
+            }
+
+            tools::VirtualClock::instance().enable(startUnixMs);
+            virtualBase_ = std::max(now_, elapsedTicks());
+            virtual_.store(true, std::memory_order_release);
+            wakeRequested_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    bool isVirtual() const { return virtual_.load(std::memory_order_acquire); }
+
+    // Scheduler time: steady_clock, or simulated under useVirtualClock().
+    TimePoint now() const {
+        if (!isVirtual()) return Clock::now();
+        return timeOf(virtualBase_ + tools::VirtualClock::instance().elapsedMs());
+    }
+
+    // Fires a task now, outside its schedule; periodic timing is not
+    // changed. A noOverlap task that is running coalesces the fire.
+    bool trigger(TaskId id) {
+        Tick planned = 0;
+        Task* t = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (stopped_) return false;
+
+            auto it = tasks_.find(id);
+            if (it == tasks_.end() || it->second->cancelled) return false;
+
+            t = it->second.get();
+            planned = elapsedTicks();
+            if (t->policy.noOverlap && t->runs > 0) {
+                if (!t->missed) {
+                    t->missed = true;
+                    t->missedDue = planned;
+                }
+                return true;
+            }
+            ++t->runs;
+        }
+        post(t, planned);
+        return true;
+    }
+
+    // O(1): a queued task is unlinked and freed right away, a running
+    // one is freed when its current run returns. Unknown ids -> false.
     bool cancel(TaskId id) {
         std::lock_guard<std::mutex> lk(mtx_);
-        return cancelSet_.insert(id).second;
+
+        auto it = tasks_.find(id);
+        if (it == tasks_.end() || it->second->cancelled) return false;
+
+        Task* t = it->second.get();
+        t->cancelled = true;
+        if (t->queued) unlink(t);
+        releaseIfDone(t);
+        return true;
     }
     void stop() {
         {
@@ -60,45 +223,50 @@ public:
         }
         cv_.notify_all();
         if (dispatcher_.joinable()) dispatcher_.join();
-        pool_.join();
+
+        // lanes_ no longer changes once stopped_ is set
+        for (auto& l : lanes_) l->stop();
+        for (auto& l : lanes_) l->join();
     }
 
     // Печать очереди
     void debugDump() {
+        const auto tasks = listTasks();
         std::lock_guard<std::mutex> lk(mtx_);
         std::cout << "\n=== Scheduler Debug Dump ===\n";
-        std::cout << "Queued tasks: " << pq_.size() << "\n";
+        std::cout << "Queued tasks: " << queued_ << "\n";
         std::cout << "Running:      " << running_.size() << "\n";
-        std::cout << "Canceled:     " << cancelSet_.size() << "\n";
+        std::cout << "Canceled:     " << cancelledRunning() << "\n";
         std::cout << "Stopped:      " << std::boolalpha << stopped_ << "\n";
-        auto copy = pq_;
-        auto now = Clock::now();
-        while (!copy.empty()) {
-            const auto& it = copy.top();
-            auto ms_left = std::chrono::duration_cast<Ms>(it.when - now).count();
+        for (const auto& it : tasks) {
             std::cout << "  id=" << it.id
                       << " name=\"" << it.name << "\""
                       << " periodic=" << it.periodic
-                      << " in=" << ms_left << " ms"
-                      << " period=" << it.period.count() << " ms\n";
-            copy.pop();
+                      << " in=" << it.msUntilRun << " ms"
+                      << " period=" << it.periodMs << " ms\n";
         }
         std::cout << "=============================\n";
     }
 
-    // Списки для программного использования
+    // Списки для программного использования (queued tasks, soonest first)
     std::vector<TaskInfo> listTasks() {
-        std::lock_guard<std::mutex> lk(mtx_);
         std::vector<TaskInfo> result;
-        result.reserve(pq_.size());
-        auto copy = pq_;
-        auto now = Clock::now();
-        while (!copy.empty()) {
-            const auto& it = copy.top();
-            long long ms_left = std::chrono::duration_cast<Ms>(it.when - now).count();
-            result.push_back(TaskInfo{it.id, it.name, it.periodic, ms_left, it.period.count()});
-            copy.pop();
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            result.reserve(queued_);
+            const long long nowMs = static_cast<long long>(elapsedTicks());
+            for (const auto& kv : tasks_) {
+                const Task& t = *kv.second;
+                if (!t.queued) continue;
+                result.push_back(TaskInfo{t.id, t.name, t.periodic,
+                                          static_cast<long long>(t.due) - nowMs,
+                                          t.period.count(),
+                                          static_cast<long long>(t.overruns)});
+            }
         }
+        std::sort(result.begin(), result.end(), [](const TaskInfo& a, const TaskInfo& b) {
+            return a.msUntilRun < b.msUntilRun || (a.msUntilRun == b.msUntilRun && a.id < b.id);
+        });
         return result;
     }
     std::vector<RunningInfo> listRunningDetailed() {
@@ -107,12 +275,34 @@ public:
         v.reserve(running_.size());
         for (const auto& kv : running_) {
             const TaskId id = kv.first;
-            const auto&   meta = kv.second; // {tid, name}
+            const auto&   meta = kv.second; // {tid, task}
             int idx = ensureWorkerIndexUnlocked(meta.tid);
-            v.push_back(RunningInfo{ id, meta.name, idx });
+            v.push_back(RunningInfo{ id, meta.task->name, idx, meta.task->lane->config().name });
+        }
+        return v;
+    }
+    std::vector<TaskStats> taskStats() {
+        std::lock_guard<std::mutex> lk(mtx_);
+        std::vector<TaskStats> v;
+        v.reserve(stats_.size());
+        for (const auto& kv : stats_) {
+            const auto& c = *kv.second;
+            v.push_back(TaskStats{kv.first, c.overruns.load(std::memory_order_relaxed),
+                                  c.late.summary(), c.run.summary()});
         }
+        std::sort(v.begin(), v.end(), [](const TaskStats& a, const TaskStats& b) {
+            return a.name < b.name;
+        });
         return v;
     }
+    void resetTaskStats() {
+        std::lock_guard<std::mutex> lk(mtx_);
+        for (auto& kv : stats_) {
+            kv.second->late.reset();
+            kv.second->run.reset();
+            kv.second->overruns.store(0, std::memory_order_relaxed);
+        }
+    }
     int workersObserved() {
         std::lock_guard<std::mutex> lk(mtx_);
         return (int)workerIndex_.size();
@@ -122,46 +312,401 @@ public:
     Scheduler& operator=(const Scheduler&) = delete;
 
 private:
-    struct Item {
-        TimePoint   when;
-        TaskId      id;
-        Fn          fn;
-        Ms          period;
-        bool        periodic;
-        std::string name;
-        bool operator<(Item const& other) const noexcept {
-            return when > other.when;
-        }
+    using Tick = std::uint64_t;   // ms since base_
+
+    static constexpr int    kBits   = GH_SCHED_WHEEL_BITS;
+    static constexpr int    kLevels = GH_SCHED_WHEEL_LEVELS;
+    static constexpr size_t kSlots  = size_t{1} << kBits;
+    static constexpr Tick   kMask   = kSlots - 1;
+    static constexpr Tick   kSpan   = (Tick{1} << (kBits * kLevels)) - 1;
+    static_assert(kBits * kLevels < 64, "timing wheel span must fit in 64 bits");
+
+    // Shared by every task with the same name; written lock-free by workers.
+    struct StatsCell {
+        Histogram                  late;
+        Histogram                  run;
+        std::atomic<std::uint64_t> overruns{0};
+    };
+
+    // Per-cycle state of a graph task; one cycle at a time.
+    struct GraphRun {
+        explicit GraphRun(TaskGraph g)
+            : graph(std::move(g)),
+              pending(new std::atomic<std::size_t>[graph.size()]),
+              stageStats(graph.size(), nullptr),
+              stageLanes(graph.size(), nullptr) {}
+
+        TaskGraph                                   graph;
+        std::unique_ptr<std::atomic<std::size_t>[]> pending;   // unfinished predecessors
+        std::atomic<std::size_t>                    remaining{0};
+        TimePoint                                   cycleStart{};
+        std::vector<StatsCell*>                     stageStats;
+        std::vector<WorkerLane*>                    stageLanes;
+    };
+
+    // Intrusive wheel node. Owned by tasks_, linked into one slot
+    // while queued; fn lives here and is never copied per fire.
+    struct Task {
+        TaskId         id{0};
+        Fn             fn;
+        Ms             period{0};
+        bool           periodic{false};
+        PeriodicPolicy policy{};
+        std::string    name;
+
+        Tick  due{0};            // tick the task fires at
+        Tick  phase{0};          // fixed-rate: scheduled tick of the last fire
+        bool  missed{false};     // noOverlap: a fire is waiting for the run to end
+        Tick  missedDue{0};      // planned tick of the first coalesced fire
+        std::uint64_t overruns{0};
+        StatsCell* stats{nullptr};
+        WorkerLane* lane{nullptr};
+        std::unique_ptr<GraphRun> graph;   // set for addGraph() tasks
+        Task* prev{nullptr};
+        Task* next{nullptr};
+        int   level{0};
+        int   slot{0};
+        bool  queued{false};
+        bool  cancelled{false};
+        int   runs{0};           // runs posted and not yet returned
     };
     struct RunningMeta {
         std::thread::id tid;
-        std::string     name;
+        const Task*     task;    // alive while it runs
     };
 
     explicit Scheduler(std::size_t threads)
-        : pool_(threads), dispatcher_(&Scheduler::loop, this) {}
+        : base_(Clock::now()), lanes_(defaultLane(threads)), dispatcher_(&Scheduler::loop, this) {}
+
+    static std::vector<std::unique_ptr<WorkerLane>> defaultLane(std::size_t threads) {
+        std::vector<std::unique_ptr<WorkerLane>> v;
+        v.push_back(std::make_unique<WorkerLane>(LaneConfig{"default", threads, {}, 0}));
+        return v;
+    }
 
     static TaskId invalidId() { return 0; }
 
-    TaskId addTask(Fn fn, TimePoint when, Ms period, bool periodic, std::string name) {
-        Item it{when, nextId_++, std::move(fn), period, periodic, std::move(name)};
+    TaskId addTask(Fn fn, TimePoint when, Ms period, bool periodic, std::string name,
+                   PeriodicPolicy policy, std::unique_ptr<GraphRun> graph = nullptr) {
+        auto t = std::make_unique<Task>();
+        t->id       = nextId_++;
+        t->fn       = std::move(fn);
+        t->period   = period;
+        t->periodic = periodic;
+        t->policy   = policy;
+        t->name     = std::move(name);
+        t->graph    = std::move(graph);
+
+        const TaskId id = t->id;
         {
             std::lock_guard<std::mutex> lk(mtx_);
             if (stopped_) return invalidId();
-            pq_.push(std::move(it));
+
+            t->lane = laneOf(policy.lane);
+            t->stats = statsCell(t->name);
+            if (t->graph) {
+                const auto& nodes = t->graph->graph.nodes();
+                for (std::size_t i = 0; i < nodes.size(); ++i) {
+                    t->graph->stageLanes[i] = nodes[i].lane ? laneOf(*nodes[i].lane) : t->lane;
+                    t->graph->stageStats[i] = statsCell(t->name + "/" + nodes[i].name);
+                }
+            }
+
+            // never into a slot the dispatcher has already passed
+            t->due = std::max(tickOf(when), now_ + 1);
+            t->phase = t->due;
+            insert(t.get());
+            tasks_.emplace(id, std::move(t));
+            wakeRequested_ = true;
         }
         cv_.notify_all();
-        return it.id;
+        return id;
+    }
+
+    // mtx_ held; lanes live until the Scheduler does
+    WorkerLane* laneOf(LaneId id) const {
+        if (id >= lanes_.size()) {
+            throw std::runtime_error("Scheduler: unknown lane " + std::to_string(id));
+        }
+        return lanes_[id].get();
+    }
+
+    // mtx_ held
+    StatsCell* statsCell(const std::string& name) {
+        auto& cell = stats_[name];
+        if (!cell) cell = std::make_unique<StatsCell>();
+        return cell.get();
+    }
+
+    // ------------------------------------------------------------
+    // Wheel (mtx_ held)
+    // ------------------------------------------------------------
+    // due ticks round up, so a task never fires early
+    Tick tickOf(TimePoint tp) const {
+        if (tp <= base_) return 0;
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(tp - base_).count();
+        return static_cast<Tick>((us + 999) / 1000);
+    }
+
+    // last tick that has fully started
+    Tick elapsedTicks() const {
+        return static_cast<Tick>(std::chrono::duration_cast<Ms>(now() - base_).count());
+    }
+
+    TimePoint timeOf(Tick t) const { return base_ + Ms(static_cast<Ms::rep>(t)); }
+
+    // Level is picked by distance from now_, the slot by the due tick
+    // itself, so a slot is cascaded no later than its tasks are due.
+    void insert(Task* t) {
+        Tick due = t->due;
+        if (due < now_) due = now_;
+        if (due - now_ > kSpan) due = now_ + kSpan;   // parked, re-cascaded
+
+        const Tick delta = due - now_;
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (Tick{1} << (kBits * (level + 1)))) ++level;
+
+        const int slot = static_cast<int>((due >> (kBits * level)) & kMask);
+
+        t->level = level;
+        t->slot = slot;
+        t->prev = nullptr;
+        t->next = wheel_[level][slot];
+        if (t->next) t->next->prev = t;
+        wheel_[level][slot] = t;
+        t->queued = true;
+        ++queued_;
+    }
+
+    void unlink(Task* t) {
+        if (t->prev) t->prev->next = t->next;
+        else         wheel_[t->level][t->slot] = t->next;
+        if (t->next) t->next->prev = t->prev;
+
+        t->prev = t->next = nullptr;
+        t->queued = false;
+        --queued_;
     }
 
-    void markRunning(TaskId id, const std::string& name, const std::thread::id& tid) {
+    Task* takeSlot(int level, int slot) {
+        Task* head = wheel_[level][slot];
+        wheel_[level][slot] = nullptr;
+        for (Task* t = head; t; t = t->next) {
+            t->queued = false;
+            --queued_;
+        }
+        return head;
+    }
+
+    // Moves now_ forward by one tick: cascades every level whose
+    // lower digits wrapped (top first), then returns level-0 tasks.
+    Task* advance() {
+        ++now_;
+
+        int top = 0;
+        while (top + 1 < kLevels && (now_ & ((Tick{1} << (kBits * (top + 1))) - 1)) == 0) ++top;
+
+        for (int level = top; level >= 1; --level) {
+            const int slot = static_cast<int>((now_ >> (kBits * level)) & kMask);
+            Task* t = takeSlot(level, slot);
+            while (t) {
+                Task* next = t->next;
+                insert(t);
+                t = next;
+            }
+        }
+
+        return takeSlot(0, static_cast<int>(now_ & kMask));
+    }
+
+    // Next tick worth waking for: the first occupied level-0 slot
+    // before the next wrap, or the wrap itself (cascade).
+    Tick nextWakeTick() const {
+        const Tick wrap = (now_ | kMask) + 1;
+        for (Tick t = now_ + 1; t < wrap; ++t) {
+            if (wheel_[0][t & kMask]) return t;
+        }
+        return wrap;
+    }
+
+    // Frees a node nobody references any more.
+    void releaseIfDone(Task* t) {
+        if (t->queued || t->runs > 0) return;
+        if (t->periodic && !t->cancelled) return;
+        tasks_.erase(t->id);
+    }
+
+    size_t cancelledRunning() const {
+        size_t n = 0;
+        for (const auto& kv : tasks_) {
+            if (kv.second->cancelled) ++n;
+        }
+        return n;
+    }
+
+    // false if the task was cancelled after it was posted
+    bool markRunning(const Task* t, const std::thread::id& tid) {
         std::lock_guard<std::mutex> lk(mtx_);
-        running_[id] = RunningMeta{tid, name};
+        if (t->cancelled) return false;
+        running_[t->id] = RunningMeta{tid, t};
         (void)ensureWorkerIndexUnlocked(tid); // присвоим индекс если новый поток
+        return true;
     }
-    void unmarkRunning(TaskId id) {
+    void finishRun(Task* t) {
+        bool again = false;
+        Tick planned = 0;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            running_.erase(t->id);
+
+            // noOverlap: the coalesced fire starts right away
+            if (t->missed && !t->cancelled && !stopped_) {
+                t->missed = false;
+                planned = t->missedDue;
+                again = true;
+            } else {
+                --t->runs;
+                releaseIfDone(t);
+            }
+        }
+        if (again) post(t, planned);
+    }
+
+    static std::uint64_t usBetween(TimePoint from, TimePoint to) {
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+        return us > 0 ? static_cast<std::uint64_t>(us) : 0;
+    }
+
+    // Virtual clock: posted jobs that have not returned yet. Time
+    // only advances at zero. A job begins before the one that posts
+    // it ends, so the count never drops to zero mid-chain.
+    void beginJob() {
+        if (!isVirtual()) return;
         std::lock_guard<std::mutex> lk(mtx_);
-        running_.erase(id);
+        ++inFlight_;
+    }
+    void endJob() {
+        if (!isVirtual()) return;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (--inFlight_ != 0) return;
+        }
+        cv_.notify_all();
+    }
+
+    void post(Task* t, Tick planned) {
+        beginJob();
+        t->lane->post([this, t, planned]() {
+            if (!markRunning(t, std::this_thread::get_id())) {
+                finishRun(t);
+                endJob();
+                return;
+            }
+
+            const auto start = now();
+            t->stats->late.record(usBetween(timeOf(planned), start));
+
+            if (t->graph) {
+                startCycle(t, start);   // the last stage calls finishRun()
+                endJob();
+                return;
+            }
+
+            try { t->fn(); } catch (...) { /* логируйте при необходимости */ }
+
+            t->stats->run.record(usBetween(start, now()));
+            finishRun(t);
+            endJob();
+        });
+    }
+
+    // ------------------------------------------------------------
+    // Graph cycles (lane threads; a graph never overlaps itself)
+    // ------------------------------------------------------------
+    void startCycle(Task* t, TimePoint start) {
+        GraphRun& g = *t->graph;
+        const auto& nodes = g.graph.nodes();
+
+        g.cycleStart = start;
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            g.pending[i].store(nodes[i].preds, std::memory_order_relaxed);
+        }
+        g.remaining.store(nodes.size(), std::memory_order_release);
+
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].preds == 0) postStage(t, i);
+        }
+    }
+
+    void postStage(Task* t, std::size_t i) {
+        const auto ready = now();
+        beginJob();
+        t->graph->stageLanes[i]->post([this, t, i, ready]() {
+            GraphRun& g = *t->graph;
+            const auto& node = g.graph.nodes()[i];
+            StatsCell* cell = g.stageStats[i];
+
+            const auto start = now();
+            cell->late.record(usBetween(ready, start));
+
+            try { node.fn(); } catch (...) { /* логируйте при необходимости */ }
+
+            const auto end = now();
+            cell->run.record(usBetween(start, end));
+            if (node.deadline.count() > 0 && end - g.cycleStart > node.deadline) {
+                cell->overruns.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            for (const auto s : node.next) {
+                if (g.pending[s].fetch_sub(1, std::memory_order_acq_rel) == 1) postStage(t, s);
+            }
+
+            if (g.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                t->stats->run.record(usBetween(g.cycleStart, end));
+                finishRun(t);
+            }
+            endJob();
+        });
+    }
+
+    void countOverruns(Task* t, std::uint64_t n) {
+        t->overruns += n;
+        t->stats->overruns.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // Tick a fire was meant to happen at (the phase grid for fixed-rate,
+    // where due may have been pulled in to catch up).
+    static Tick plannedTick(const Task* t) {
+        return t->policy.mode == Periodic::FIXED_DELAY ? t->due : t->phase;
+    }
+
+    // Puts a periodic task that just fired back into the wheel.
+    // now_ is the current tick and its level-0 slot is already drained.
+    void reschedule(Task* t) {
+        const Tick period = static_cast<Tick>(t->period.count());
+
+        switch (t->policy.mode) {
+            case Periodic::FIXED_DELAY:
+                t->due = now_ + period;
+                break;
+
+            case Periodic::FIXED_RATE_CATCH_UP:
+                t->phase += period;
+                t->due = std::max(t->phase, now_ + 1);
+                break;
+
+            case Periodic::FIXED_RATE_SKIP:
+                t->phase += period;
+                if (t->phase <= now_) {
+                    const Tick missed = (now_ - t->phase) / period + 1;
+                    t->phase += missed * period;
+                    countOverruns(t, missed);
+                }
+                t->due = t->phase;
+                break;
+        }
+
+        insert(t);
     }
     int ensureWorkerIndexUnlocked(const std::thread::id& tid) {
         auto it = workerIndex_.find(tid);
@@ -171,65 +716,116 @@ private:
         return idx;
     }
 
+    // Virtual clock: once nothing is in flight, jump to the next tick
+    // worth waking for. With nothing queued, time stands still until
+    // a task is added.
+    void waitVirtual(std::unique_lock<std::mutex>& lk) {
+        cv_.wait(lk, [&]{ return stopped_ || wakeRequested_ || inFlight_ == 0; });
+        if (stopped_) return;
+        if (wakeRequested_) {
+            wakeRequested_ = false;
+            return;
+        }
+
+        if (queued_ == 0) {
+            cv_.wait(lk, [&]{ return stopped_ || wakeRequested_; });
+            wakeRequested_ = false;
+            return;
+        }
+
+        tools::VirtualClock::instance().advanceTo(nextWakeTick() - virtualBase_);
+    }
+
     void loop() {
+        struct Fire {
+            Task* task;
+            Tick  planned;
+        };
+        std::vector<Fire> fire;
+
         std::unique_lock<std::mutex> lk(mtx_);
         for (;;) {
             if (stopped_) break;
 
-            if (pq_.empty()) {
-                cv_.wait(lk, [&]{ return stopped_ || !pq_.empty(); });
-                if (stopped_) break;
-            }
+            const Tick target = elapsedTicks();
+            while (now_ < target) {
+                Task* t = advance();
+                while (t) {
+                    Task* next = t->next;
+                    t->prev = t->next = nullptr;
+                    if (!t->cancelled) {
+                        const Tick planned = plannedTick(t);
+                        if (t->periodic) reschedule(t);
 
-            auto now = Clock::now();
-            auto next = pq_.top();
+                        if (t->policy.noOverlap && t->runs > 0) {
+                            if (t->missed) {
+                                countOverruns(t, 1);
+                            } else {
+                                t->missed = true;
+                                t->missedDue = planned;
+                            }
+                        } else {
+                            ++t->runs;
+                            fire.push_back(Fire{t, planned});
+                        }
+                    }
+                    t = next;
+                }
+            }
 
-            if (next.when > now) {
-                cv_.wait_until(lk, next.when, [&]{
-                    return stopped_ || pq_.empty() || pq_.top().when != next.when;
-                });
+            if (fire.empty() && isVirtual()) {
+                waitVirtual(lk);
                 continue;
             }
 
-            pq_.pop();
-
-            if (cancelSet_.erase(next.id) > 0) {
+            if (fire.empty()) {
+                const Tick wake = nextWakeTick();
+                cv_.wait_until(lk, timeOf(wake), [&]{
+                    return stopped_ || elapsedTicks() >= wake || wakeRequested_;
+                });
+                wakeRequested_ = false;
                 continue;
             }
 
-            auto id_copy   = next.id;
-            auto fn_copy   = next.fn;
-            auto name_copy = next.name;
-
             lk.unlock();
-            boost::asio::post(pool_, [this, fn = std::move(fn_copy), id_copy, name_copy]() mutable {
-                auto tid = std::this_thread::get_id();
-                markRunning(id_copy, name_copy, tid);
-                try { fn(); } catch (...) { /* логируйте при необходимости */ }
-                unmarkRunning(id_copy);
-            });
+            for (const Fire& f : fire) post(f.task, f.planned);
+            fire.clear();
             lk.lock();
-
-            if (next.periodic && cancelSet_.count(id_copy) == 0 && !stopped_) {
-                next.when = Clock::now() + next.period; // fixed-delay
-                pq_.push(std::move(next));
-            }
         }
     }
 
 private:
-    boost::asio::thread_pool   pool_;
-    std::thread                dispatcher_;
+    TimePoint                  base_;
+    // lanes_[LaneId]; only appended, under mtx_
+    std::vector<std::unique_ptr<WorkerLane>> lanes_;
     std::mutex                 mtx_;
     std::condition_variable    cv_;
-    std::priority_queue<Item>  pq_;
-    std::unordered_set<TaskId> cancelSet_;
 
-    // running_[taskId] -> {thread_id, name}
+    // wheel_[level][slot] -> intrusive list of queued tasks
+    Task*                      wheel_[kLevels][kSlots]{};
+    Tick                       now_{0};      // last tick processed
+    size_t                     queued_{0};
+    bool                       wakeRequested_{false};
+
+    // virtual clock (useVirtualClock): tick of simulated time 0, jobs in flight
+    std::atomic<bool>          virtual_{false};
+    Tick                       virtualBase_{0};
+    size_t                     inFlight_{0};
+
+    // every live task: queued, running, or both (periodic)
+    std::unordered_map<TaskId, std::unique_ptr<Task>> tasks_;
+
+    // task name -> run statistics, never erased
+    std::unordered_map<std::string, std::unique_ptr<StatsCell>> stats_;
+
+    // running_[taskId] -> {thread_id, task}
     std::unordered_map<TaskId, RunningMeta> running_;
     // thread_id -> stable index (W0, W1, ...)
     std::unordered_map<std::thread::id, int> workerIndex_;
 
     std::atomic<TaskId>        nextId_{1};
     bool                       stopped_{false};
+
+    // last: starts after every member above is constructed
+    std::thread                dispatcher_;
 };
@@ -0,0 +1,88 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "WorkerLane.hpp"
+
+// ------------------------------------------------------------
+// Static DAG of stages, run by Scheduler::addGraph().
+// A stage is posted to the pool as soon as every stage before it
+// has returned; stages without a predecessor start the cycle.
+// ------------------------------------------------------------
+class TaskGraph final {
+public:
+    using Fn     = std::function<void()>;
+    using Ms     = std::chrono::milliseconds;
+    using NodeId = std::size_t;
+
+    struct Node {
+        std::string         name;
+        Fn                  fn;
+        Ms                  deadline{0};   // from cycle start, 0 = none
+        std::vector<NodeId> next;
+        std::size_t         preds{0};
+        std::optional<LaneId> lane;        // unset = the graph task's lane
+    };
+
+    NodeId add(std::string name, Fn fn, Ms deadline = Ms::zero()) {
+        if (!fn) throw std::runtime_error("TaskGraph::add: empty function for stage " + name);
+        nodes_.push_back(Node{std::move(name), std::move(fn), deadline, {}, 0, std::nullopt});
+        return nodes_.size() - 1;
+    }
+
+    // after starts once before (and all its other predecessors) returned
+    void precede(NodeId before, NodeId after) {
+        if (before >= nodes_.size() || after >= nodes_.size() || before == after) {
+            throw std::runtime_error("TaskGraph::precede: bad stage id");
+        }
+        nodes_[before].next.push_back(after);
+        ++nodes_[after].preds;
+    }
+
+    NodeId then(NodeId before, std::string name, Fn fn, Ms deadline = Ms::zero()) {
+        const NodeId id = add(std::move(name), std::move(fn), deadline);
+        precede(before, id);
+        return id;
+    }
+
+    // e.g. a blocking I/O stage inside an otherwise real-time graph
+    void runOn(NodeId id, LaneId lane) {
+        if (id >= nodes_.size()) throw std::runtime_error("TaskGraph::runOn: bad stage id");
+        nodes_[id].lane = lane;
+    }
+
+    const std::vector<Node>& nodes() const { return nodes_; }
+    std::size_t size() const { return nodes_.size(); }
+
+    // Throws if the graph is empty or has a cycle.
+    void validate() const {
+        if (nodes_.empty()) throw std::runtime_error("TaskGraph: no stages");
+
+        std::vector<std::size_t> preds(nodes_.size());
+        std::vector<NodeId> ready;
+        for (NodeId i = 0; i < nodes_.size(); ++i) {
+            preds[i] = nodes_[i].preds;
+            if (preds[i] == 0) ready.push_back(i);
+        }
+
+        std::size_t seen = 0;
+        while (!ready.empty()) {
+            const NodeId n = ready.back();
+            ready.pop_back();
+            ++seen;
+            for (NodeId s : nodes_[n].next) {
+                if (--preds[s] == 0) ready.push_back(s);
+            }
+        }
+
+        if (seen != nodes_.size()) throw std::runtime_error("TaskGraph: stages form a cycle");
+    }
+
+private:
+    std::vector<Node> nodes_;
+};
@@ -0,0 +1,115 @@
+#pragma once
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Index of a lane inside a Scheduler; 0 is the default pool.
+using LaneId = std::uint32_t;
+
+// ------------------------------------------------------------
+// Lane setup. cpus and fifoPriority are best effort: if the
+// kernel refuses (no CAP_SYS_NICE, core not present) the lane
+// logs once and keeps running with normal scheduling.
+// ------------------------------------------------------------
+struct LaneConfig {
+    std::string      name;
+    std::size_t      threads{1};
+    std::vector<int> cpus;              // pin every thread to these cores, empty = any
+    int              fifoPriority{0};   // SCHED_FIFO 1..99, 0 = SCHED_OTHER
+};
+
+// ------------------------------------------------------------
+// Fixed set of worker threads draining one queue. Tasks on
+// different lanes never wait for each other's threads.
+// ------------------------------------------------------------
+class WorkerLane final {
+public:
+    explicit WorkerLane(LaneConfig cfg)
+        : cfg_(std::move(cfg)), guard_(boost::asio::make_work_guard(ctx_)) {
+        if (cfg_.threads == 0) cfg_.threads = 1;
+        threads_.reserve(cfg_.threads);
+        for (std::size_t i = 0; i < cfg_.threads; ++i) {
+            threads_.emplace_back(&WorkerLane::run, this, i);
+        }
+    }
+
+    ~WorkerLane() {
+        stop();
+        ctx_.stop();
+        join();
+    }
+
+    template <class F>
+    void post(F&& f) { boost::asio::post(ctx_, std::forward<F>(f)); }
+
+    // Threads exit once the queue is drained.
+    void stop() { guard_.reset(); }
+
+    void join() {
+        for (auto& t : threads_) {
+            if (t.joinable()) t.join();
+        }
+    }
+
+    const LaneConfig& config() const { return cfg_; }
+
+    WorkerLane(const WorkerLane&) = delete;
+    WorkerLane& operator=(const WorkerLane&) = delete;
+
+private:
+    void run(std::size_t index) {
+        setupThread(index);
+        ctx_.run();
+    }
+
+    void setupThread(std::size_t index) {
+        const pthread_t self = pthread_self();
+        const bool report = index == 0;
+
+        // kernel limit: 15 chars
+        const std::string tname = (cfg_.name + "-" + std::to_string(index)).substr(0, 15);
+        pthread_setname_np(self, tname.c_str());
+
+        if (!cfg_.cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const int c : cfg_.cpus) {
+                if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+            }
+            const int rc = pthread_setaffinity_np(self, sizeof(set), &set);
+            if (rc != 0 && report) {
+                std::cout << "[SCHED] lane " << cfg_.name << ": affinity not applied: "
+                          << std::strerror(rc) << "\n";
+            }
+        }
+
+        if (cfg_.fifoPriority > 0) {
+            sched_param sp{};
+            sp.sched_priority = std::clamp(cfg_.fifoPriority,
+                                           sched_get_priority_min(SCHED_FIFO),
+                                           sched_get_priority_max(SCHED_FIFO));
+            const int rc = pthread_setschedparam(self, SCHED_FIFO, &sp);
+            if (rc != 0 && report) {
+                std::cout << "[SCHED] lane " << cfg_.name << ": SCHED_FIFO "
+                          << sp.sched_priority << " not applied: " << std::strerror(rc) << "\n";
+            }
+        }
+    }
+
+    LaneConfig               cfg_;
+    boost::asio::io_context  ctx_;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> guard_;
+    std::vector<std::thread> threads_;
+};
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace storage {
+
+// ------------------------------------------------------------
+// Bit streams (MSB first)
+// ------------------------------------------------------------
+class BitWriter {
+public:
+    void write(uint64_t bits, int n) {
+        for (int i = n - 1; i >= 0; --i) {
+            if (used_ == 0) bytes_.push_back(0);
+            if ((bits >> i) & 1u) bytes_.back() |= static_cast<uint8_t>(0x80u >> used_);
+            used_ = (used_ + 1) & 7;
+        }
+    }
+
+    void writeBit(bool b) { write(b ? 1u : 0u, 1); }
+
+    const std::vector<uint8_t>& bytes() const { return bytes_; }
+
+private:
+    std::vector<uint8_t> bytes_;
+    int used_{0};   // bits used in the last byte
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : data_(data), bits_(size * 8) {}
+
+    uint64_t read(int n) {
+        if (pos_ + static_cast<size_t>(n) > bits_)
+            throw std::runtime_error("Gorilla: bit stream truncated");
+
+        uint64_t v = 0;
+        for (int i = 0; i < n; ++i) {
+            const size_t p = pos_++;
+            v = (v << 1) | ((data_[p >> 3] >> (7 - (p & 7))) & 1u);
+        }
+        return v;
+    }
+
+    bool readBit() { return read(1) != 0; }
+
+private:
+    const uint8_t* data_;
+    size_t bits_;
+    size_t pos_{0};
+};
+
+// ------------------------------------------------------------
+// Timestamps: delta-of-delta with Gorilla buckets
+//   0                  '0'
+//   [-63, 64]          '10'   + 7 bits
+//   [-255, 256]        '110'  + 9 bits
+//   [-2047, 2048]      '1110' + 12 bits
+//   otherwise          '1111' + 64 bits
+// The first timestamp is stored in the block header, the first
+// delta is encoded as a delta-of-delta against 0.
+// ------------------------------------------------------------
+class TimestampEncoder {
+public:
+    explicit TimestampEncoder(int64_t first) : prev_(first) {}
+
+    void add(int64_t t) {
+        const int64_t delta = t - prev_;
+        const int64_t dod = delta - prevDelta_;
+
+        if (dod == 0) {
+            w_.writeBit(false);
+        } else if (dod >= -63 && dod <= 64) {
+            w_.write(0b10, 2);
+            w_.write(static_cast<uint64_t>(dod + 63), 7);
+        } else if (dod >= -255 && dod <= 256) {
+            w_.write(0b110, 3);
+            w_.write(static_cast<uint64_t>(dod + 255), 9);
+        } else if (dod >= -2047 && dod <= 2048) {
+            w_.write(0b1110, 4);
+            w_.write(static_cast<uint64_t>(dod + 2047), 12);
+        } else {
+            w_.write(0b1111, 4);
+            w_.write(static_cast<uint64_t>(dod), 64);
+        }
+
+        prevDelta_ = delta;
+        prev_ = t;
+    }
+
+    const std::vector<uint8_t>& bytes() const { return w_.bytes(); }
+
+private:
+    BitWriter w_;
+    int64_t prev_;
+    int64_t prevDelta_{0};
+};
+
+class TimestampDecoder {
+public:
+    TimestampDecoder(int64_t first, const uint8_t* data, size_t size)
+        : r_(data, size), prev_(first) {}
+
+    int64_t next() {
+        int64_t dod = 0;
+
+        if (!r_.readBit()) {
+            dod = 0;
+        } else if (!r_.readBit()) {
+            dod = static_cast<int64_t>(r_.read(7)) - 63;
+        } else if (!r_.readBit()) {
+            dod = static_cast<int64_t>(r_.read(9)) - 255;
+        } else if (!r_.readBit()) {
+            dod = static_cast<int64_t>(r_.read(12)) - 2047;
+        } else {
+            dod = static_cast<int64_t>(r_.read(64));
+        }
+
+        prevDelta_ += dod;
+        prev_ += prevDelta_;
+        return prev_;
+    }
+
+private:
+    BitReader r_;
+    int64_t prev_;
+    int64_t prevDelta_{0};
+};
+
+// ------------------------------------------------------------
+// Values: Gorilla XOR
+//   same as previous     '0'
+//   fits previous window '10' + meaningful bits
+//   new window           '11' + 5 bits leading zeros
+//                             + 6 bits (length - 1) + bits
+// ------------------------------------------------------------
+inline uint64_t doubleBits(double v) {
+    uint64_t b;
+    std::memcpy(&b, &v, sizeof b);
+    return b;
+}
+
+inline double bitsDouble(uint64_t b) {
+    double v;
+    std::memcpy(&v, &b, sizeof v);
+    return v;
+}
+
+class ValueEncoder {
+public:
+    void add(double v) {
+        const uint64_t bits = doubleBits(v);
+
+        if (first_) {
+            w_.write(bits, 64);
+            prev_ = bits;
+            first_ = false;
+            return;
+        }
+
+        const uint64_t x = bits ^ prev_;
+        prev_ = bits;
+
+        if (x == 0) {
+            w_.writeBit(false);
+            return;
+        }
+        w_.writeBit(true);
+
+        int leading = __builtin_clzll(x);
+        const int trailing = __builtin_ctzll(x);
+        if (leading > 31) leading = 31;
+
+        if (window_ && leading >= leading_ && trailing >= trailing_) {
+            w_.writeBit(false);
+            w_.write(x >> trailing_, 64 - leading_ - trailing_);
+            return;
+        }
+
+        const int len = 64 - leading - trailing;
+        w_.writeBit(true);
+        w_.write(static_cast<uint64_t>(leading), 5);
+        w_.write(static_cast<uint64_t>(len - 1), 6);
+        w_.write(x >> trailing, len);
+
+        window_ = true;
+        leading_ = leading;
+        trailing_ = trailing;
+    }
+
+    const std::vector<uint8_t>& bytes() const { return w_.bytes(); }
+
+private:
+    BitWriter w_;
+    uint64_t prev_{0};
+    bool first_{true};
+    bool window_{false};
+    int leading_{0};
+    int trailing_{0};
+};
+
+class ValueDecoder {
+public:
+    ValueDecoder(const uint8_t* data, size_t size) : r_(data, size) {}
+
+    double next() {
+        if (first_) {
+            prev_ = r_.read(64);
+            first_ = false;
+            return bitsDouble(prev_);
+        }
+
+        if (!r_.readBit()) return bitsDouble(prev_);
+
+        if (r_.readBit()) {
+            leading_ = static_cast<int>(r_.read(5));
+            const int len = static_cast<int>(r_.read(6)) + 1;
+            trailing_ = 64 - leading_ - len;
+        }
+
+        const int len = 64 - leading_ - trailing_;
+        prev_ ^= r_.read(len) << trailing_;
+        return bitsDouble(prev_);
+    }
+
+private:
+    BitReader r_;
+    uint64_t prev_{0};
+    bool first_{true};
+    int leading_{0};
+    int trailing_{0};
+};
+
+} // namespace storage
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace storage {
+
+// ------------------------------------------------------------
+// Read-only mapping of a whole file.
+// data stays null for missing or empty files.
+// ------------------------------------------------------------
+struct MappedFile {
+    explicit MappedFile(const std::string& path) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) return;
+
+        size = static_cast<size_t>(st.st_size);
+        void* p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            size = 0;
+            return;
+        }
+        data = static_cast<const uint8_t*>(p);
+    }
+
+    ~MappedFile() {
+        if (data) ::munmap(const_cast<uint8_t*>(data), size);
+        if (fd >= 0) ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    int fd{-1};
+    const uint8_t* data{nullptr};
+    size_t size{0};
+};
+
+} // namespace storage
@@ -0,0 +1,641 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../GlobalState.hpp"
+#include "MappedFile.hpp"
+
+// ------------------------------------------------------------
+// Journal policy: appends are buffered and written + fdatasync'ed
+// together every GH_JOURNAL_SYNC_MS. A checkpoint of the full
+// executor state is taken every GH_JOURNAL_CHECKPOINT_MS (if
+// anything changed) or once the live segment reaches
+// GH_JOURNAL_SEGMENT_BYTES; older segments are deleted then.
+// ------------------------------------------------------------
+#ifndef GH_JOURNAL_SYNC_MS
+#define GH_JOURNAL_SYNC_MS 200
+#endif
+
+#ifndef GH_JOURNAL_SEGMENT_BYTES
+#define GH_JOURNAL_SEGMENT_BYTES (1024 * 1024)
+#endif
+
+#ifndef GH_JOURNAL_CHECKPOINT_MS
+#define GH_JOURNAL_CHECKPOINT_MS (10 * 60 * 1000)
+#endif
+
+namespace storage {
+
+// ------------------------------------------------------------
+// Write-ahead journal of executor desired / actual state.
+//
+// Every desired or actual transition (value, validity, mode) is
+// one small CRC-checked record in <dir>/seg-<N>.wal. A checkpoint
+// <dir>/ckp-<N>.ckp holds the full state as of the start of
+// segment N, so recovery is: newest checkpoint + segments >= N,
+// read through mmap, stopping at the first torn record.
+//
+// Records carry absolute state, never deltas, so replaying one
+// twice is harmless.
+// ------------------------------------------------------------
+class StateJournal final {
+public:
+    using Value = GH_GlobalState::Value;
+    using ValueType = GH_GlobalState::ValueType;
+
+    struct Part {
+        bool valid{false};
+        GH_MODE mode{GH_MODE::MANUAL};
+        Value value;
+        uint64_t stampMs{0};
+
+        bool sameState(const Part& o) const {
+            return valid == o.valid && mode == o.mode && value == o.value;
+        }
+    };
+
+    struct ExecState {
+        bool hasDesired{false};
+        Part desired;
+        bool hasActual{false};
+        Part actual;
+    };
+
+    // keyed by executor name, ids may move when the config changes
+    using State = std::map<std::string, ExecState>;
+    using StateProvider = std::function<State()>;
+
+    static StateJournal& instance() {
+        static StateJournal inst;
+        return inst;
+    }
+
+    ~StateJournal() { stop(); }
+
+    // ------------------------------------------------------------
+    // Lifecycle
+    // ------------------------------------------------------------
+    // Creates dir, replays checkpoint + segments and returns the
+    // recovered state. A torn tail of the last segment is cut off.
+    State open(const std::string& dir) {
+        namespace fs = std::filesystem;
+
+        fs::create_directories(dir);
+        dir_ = dir;
+
+        uint64_t ckpSeq = 0;
+        bool haveCkp = false;
+        std::vector<uint64_t> segs;
+
+        for (const auto& e : fs::directory_iterator(dir_)) {
+            if (!e.is_regular_file()) continue;
+
+            const std::string name = e.path().filename().string();
+            uint64_t seq = 0;
+
+            if (parseSeq(name, "ckp-", ".ckp", seq)) {
+                if (!haveCkp || seq > ckpSeq) ckpSeq = seq;
+                haveCkp = true;
+            } else if (parseSeq(name, "seg-", ".wal", seq)) {
+                segs.push_back(seq);
+            } else if (e.path().extension() == ".tmp") {
+                fs::remove(e.path());
+            }
+        }
+        std::sort(segs.begin(), segs.end());
+
+        State st;
+        nextSeq_ = haveCkp ? ckpSeq + 1 : 0;
+
+        if (haveCkp) {
+            replayFile(pathFor("ckp-", ckpSeq, ".ckp"), st, false);
+        }
+
+        for (const uint64_t seq : segs) {
+            nextSeq_ = std::max(nextSeq_, seq + 1);
+            if (haveCkp && seq < ckpSeq) continue;
+
+            replayFile(pathFor("seg-", seq, ".wal"), st, true);
+        }
+
+        // what is on disk now is what record() compares against
+        {
+            std::lock_guard<std::mutex> lk(buf_mtx_);
+            last_.clear();
+            for (const auto& kv : st) {
+                if (kv.second.hasDesired) last_[key(KIND_DESIRED, kv.first)] = kv.second.desired;
+                if (kv.second.hasActual)  last_[key(KIND_ACTUAL, kv.first)] = kv.second.actual;
+            }
+        }
+
+        opened_ = true;
+        return st;
+    }
+
+    bool isOpen() const { return opened_; }
+
+    // Takes the first checkpoint right away, so the replayed
+    // segments can go, then starts the flusher.
+    void start(StateProvider provider) {
+        if (!opened_) throw std::runtime_error("StateJournal: open() before start()");
+        if (flusher_.joinable()) return;
+
+        provider_ = std::move(provider);
+        {
+            std::lock_guard<std::mutex> lk(buf_mtx_);
+            stopping_ = false;
+            started_ = true;
+        }
+
+        checkpoint();
+        flusher_ = std::thread(&StateJournal::flushLoop, this);
+    }
+
+    // Flushes the buffer and leaves a fresh checkpoint behind.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lk(buf_mtx_);
+            if (!started_) return;
+            stopping_ = true;
+        }
+        cv_.notify_all();
+
+        if (flusher_.joinable()) flusher_.join();
+
+        flushBuffer();
+        checkpoint();
+        closeSegment();
+
+        std::lock_guard<std::mutex> lk(buf_mtx_);
+        started_ = false;
+    }
+
+    // ------------------------------------------------------------
+    // Write side: GH_GlobalState write observer.
+    // Only executor transitions are journaled, a write that leaves
+    // valid / mode / value unchanged is dropped.
+    // ------------------------------------------------------------
+    void record(const GH_GlobalState::StateWrite& w) {
+        using K = GH_GlobalState::StateWriteKind;
+        if (w.kind == K::GETTER) return;
+
+        const uint8_t kind = (w.kind == K::EXEC_DESIRED) ? KIND_DESIRED : KIND_ACTUAL;
+
+        Part p;
+        p.valid = w.valid;
+        p.mode = w.mode;
+        p.value = w.value;
+        p.stampMs = w.stampMs;
+
+        std::lock_guard<std::mutex> lk(buf_mtx_);
+        if (!started_) return;
+
+        auto& last = last_[key(kind, w.name)];
+        if (last.stampMs != 0 && last.sameState(p)) return;
+
+        encodeRecord(buf_, kind, w.name, p);
+        last = std::move(p);
+        ++sinceCheckpoint_;
+    }
+
+    // ------------------------------------------------------------
+    // GH_GlobalState <-> State
+    // ------------------------------------------------------------
+    static State fromSnapshot(const GH_GlobalState::ExecSnapshot& snap) {
+        State st;
+
+        for (const auto& r : snap.slots) {
+            const auto& d = r->state.desired;
+            const auto& a = r->state.actual;
+
+            auto& e = st[r->name];
+            e.hasDesired = d.stampMs != 0;
+            e.desired = Part{d.valid, d.mode, d.value, d.stampMs};
+            e.hasActual = a.stampMs != 0;
+            e.actual = Part{a.valid, a.mode, a.value, a.stampMs};
+        }
+
+        return st;
+    }
+
+    // Writes recovered state into registered executors and returns
+    // how many were restored. Actual state is trusted as applied;
+    // desired is only marked dirty where it differs from actual,
+    // so the bridge re-drives nothing that is already in place.
+    static size_t restore(GH_GlobalState& gs, const State& st) {
+        size_t restored = 0;
+
+        for (const auto& kv : st) {
+            GH_GlobalState::ExecHandle h;
+            if (!gs.findExecHandle(kv.first, h)) continue;
+
+            const auto type = gs.execType(h);
+            const auto usable = [type](const Part& p) {
+                return !p.value.hasValue() || p.value.type == type;
+            };
+
+            const auto& e = kv.second;
+            if ((e.hasActual && !usable(e.actual)) || (e.hasDesired && !usable(e.desired))) {
+                std::cout << "[JOURNAL] type changed, not restoring " << kv.first << "\n";
+                continue;
+            }
+
+            if (e.hasActual) {
+                if (e.actual.valid) {
+                    gs.setExecActual(h, e.actual.value, e.actual.mode, false);
+                } else {
+                    gs.setExecActualMode(h, e.actual.mode);
+                    gs.setExecActualInvalid(h, "restored invalid");
+                }
+            }
+
+            if (e.hasDesired) {
+                const bool dirty = !e.hasActual || !e.desired.valid || !e.actual.valid ||
+                                   !(e.desired.value == e.actual.value) ||
+                                   e.desired.mode != e.actual.mode;
+
+                if (e.desired.valid) {
+                    gs.setExecDesired(h, e.desired.value, e.desired.mode, "journal", dirty);
+                } else {
+                    gs.setExecDesiredMode(h, e.desired.mode, "journal", false);
+                    gs.setExecDesiredInvalid(h, "journal", dirty);
+                }
+            }
+
+            if (e.hasActual || e.hasDesired) ++restored;
+        }
+
+        return restored;
+    }
+
+private:
+    StateJournal() = default;
+    StateJournal(const StateJournal&) = delete;
+    StateJournal& operator=(const StateJournal&) = delete;
+
+    // ------------------------------------------------------------
+    // Record layout (host byte order):
+    //   u16 bodyLen | body | u32 crc32(body)
+    // body:
+    //   u8 kind | u8 flags | u8 mode | u8 valueType | i64 stampMs |
+    //   u16 nameLen | name | value
+    // value: BOOL 1, INT 4, DOUBLE 8, TIME 8 bytes, STRING the
+    // remaining bytes; absent when flags has no FLAG_HAS_VALUE.
+    // ------------------------------------------------------------
+    static constexpr uint8_t KIND_DESIRED = 1;
+    static constexpr uint8_t KIND_ACTUAL = 2;
+
+    static constexpr uint8_t FLAG_VALID = 0x01;
+    static constexpr uint8_t FLAG_HAS_VALUE = 0x02;
+
+    static constexpr size_t kBodyFixed = 1 + 1 + 1 + 1 + 8 + 2;
+
+    static constexpr uint32_t kCkpMagic = 0x4B434847;   // "GHCK"
+
+    static uint32_t crc32(const uint8_t* data, size_t len) {
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < len; ++i) {
+            crc ^= data[i];
+            for (int b = 0; b < 8; ++b) {
+                crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+            }
+        }
+        return ~crc;
+    }
+
+    template<class T>
+    static void put(std::vector<uint8_t>& out, const T& v) {
+        const auto* p = reinterpret_cast<const uint8_t*>(&v);
+        out.insert(out.end(), p, p + sizeof v);
+    }
+
+    template<class T>
+    static T take(const uint8_t* p) {
+        T v;
+        std::memcpy(&v, p, sizeof v);
+        return v;
+    }
+
+    static void encodeRecord(std::vector<uint8_t>& out, uint8_t kind,
+                             const std::string& name, const Part& p) {
+        const size_t start = out.size();
+        put<uint16_t>(out, 0);   // patched below
+
+        const Value& v = p.value;
+        const uint8_t flags = (p.valid ? FLAG_VALID : 0) | (v.hasValue() ? FLAG_HAS_VALUE : 0);
+
+        put<uint8_t>(out, kind);
+        put<uint8_t>(out, flags);
+        put<uint8_t>(out, static_cast<uint8_t>(p.mode));
+        put<uint8_t>(out, static_cast<uint8_t>(v.type));
+        put<int64_t>(out, static_cast<int64_t>(p.stampMs));
+        put<uint16_t>(out, static_cast<uint16_t>(name.size()));
+        out.insert(out.end(), name.begin(), name.end());
+
+        if (v.hasValue()) {
+            switch (v.type) {
+                case ValueType::BOOL:   put<uint8_t>(out, v.num.b ? 1 : 0); break;
+                case ValueType::INT:    put<int32_t>(out, v.num.i); break;
+                case ValueType::DOUBLE: put<double>(out, v.num.d); break;
+                case ValueType::TIME:   put<int64_t>(out, v.num.ms); break;
+                case ValueType::STRING: out.insert(out.end(), v.str.begin(), v.str.end()); break;
+            }
+        }
+
+        const size_t bodyLen = out.size() - start - sizeof(uint16_t);
+        if (bodyLen > 0xFFFF) {
+            out.resize(start);   // oversized string value, not journaled
+            return;
+        }
+
+        const uint16_t len16 = static_cast<uint16_t>(bodyLen);
+        std::memcpy(out.data() + start, &len16, sizeof len16);
+        put<uint32_t>(out, crc32(out.data() + start + sizeof(uint16_t), bodyLen));
+    }
+
+    // Decodes one record at data[0..size). Returns its total size,
+    // or 0 when the record is torn or corrupt.
+    static size_t decodeRecord(const uint8_t* data, size_t size, State& st) {
+        if (size < sizeof(uint16_t)) return 0;
+
+        const size_t bodyLen = take<uint16_t>(data);
+        const size_t total = sizeof(uint16_t) + bodyLen + sizeof(uint32_t);
+        if (bodyLen < kBodyFixed || total > size) return 0;
+
+        const uint8_t* b = data + sizeof(uint16_t);
+        if (take<uint32_t>(b + bodyLen) != crc32(b, bodyLen)) return 0;
+
+        const uint8_t kind = b[0];
+        const uint8_t flags = b[1];
+        const uint8_t mode = b[2];
+        const uint8_t type = b[3];
+        const int64_t stamp = take<int64_t>(b + 4);
+        const size_t nameLen = take<uint16_t>(b + 12);
+
+        if ((kind != KIND_DESIRED && kind != KIND_ACTUAL) || mode > 1 ||
+            type > static_cast<uint8_t>(ValueType::TIME) || kBodyFixed + nameLen > bodyLen) {
+            return 0;
+        }
+
+        const std::string name(reinterpret_cast<const char*>(b + kBodyFixed), nameLen);
+        const uint8_t* vp = b + kBodyFixed + nameLen;
+        const size_t vlen = bodyLen - kBodyFixed - nameLen;
+
+        Part p;
+        p.valid = (flags & FLAG_VALID) != 0;
+        p.mode = static_cast<GH_MODE>(mode);
+        p.stampMs = static_cast<uint64_t>(stamp);
+        p.value.type = static_cast<ValueType>(type);
+
+        if (flags & FLAG_HAS_VALUE) {
+            const auto need = [vlen](size_t n) {
+                if (vlen != n) throw std::runtime_error("bad value size");
+            };
+
+            try {
+                switch (p.value.type) {
+                    case ValueType::BOOL:   need(1); p.value = Value::of(vp[0] != 0); break;
+                    case ValueType::INT:    need(4); p.value = Value::of(static_cast<int>(take<int32_t>(vp))); break;
+                    case ValueType::DOUBLE: need(8); p.value = Value::of(take<double>(vp)); break;
+                    case ValueType::TIME:   need(8); p.value = Value::of(tools::UnixMs(take<int64_t>(vp))); break;
+                    case ValueType::STRING:
+                        p.value = Value::of(std::string(reinterpret_cast<const char*>(vp), vlen));
+                        break;
+                }
+            } catch (const std::exception&) {
+                return 0;
+            }
+        }
+
+        auto& e = st[name];
+        if (kind == KIND_DESIRED) {
+            e.hasDesired = true;
+            e.desired = std::move(p);
+        } else {
+            e.hasActual = true;
+            e.actual = std::move(p);
+        }
+
+        return total;
+    }
+
+    // Applies every record of a checkpoint or segment to st.
+    void replayFile(const std::string& path, State& st, bool segment) {
+        size_t good = 0;
+        size_t size = 0;
+        size_t count = 0;
+        {
+            MappedFile f(path);
+            if (!f.data) return;
+            size = f.size;
+
+            if (!segment) {
+                if (f.size < 12 || take<uint32_t>(f.data) != kCkpMagic) {
+                    std::cout << "[JOURNAL] ignoring bad checkpoint " << path << "\n";
+                    return;
+                }
+                good = 12;
+            }
+
+            while (good < f.size) {
+                const size_t n = decodeRecord(f.data + good, f.size - good, st);
+                if (n == 0) break;
+                good += n;
+                ++count;
+            }
+        }
+
+        std::cout << "[JOURNAL] replayed " << count << " records from " << path << "\n";
+
+        if (segment && good != size) {
+            std::cout << "[JOURNAL] truncating torn tail of " << path << "\n";
+            if (::truncate(path.c_str(), static_cast<off_t>(good)) != 0) {
+                std::cout << "[JOURNAL] truncate failed for " << path << "\n";
+            }
+        }
+    }
+
+    // ------------------------------------------------------------
+    // Files (flusher thread, or start/stop while it is not running)
+    // ------------------------------------------------------------
+    static bool parseSeq(const std::string& name, const char* prefix,
+                         const char* ext, uint64_t& out) {
+        const size_t pl = std::strlen(prefix);
+        const size_t el = std::strlen(ext);
+        if (name.size() <= pl + el) return false;
+        if (name.compare(0, pl, prefix) != 0) return false;
+        if (name.compare(name.size() - el, el, ext) != 0) return false;
+
+        const std::string digits = name.substr(pl, name.size() - pl - el);
+        if (digits.find_first_not_of("0123456789") != std::string::npos) return false;
+
+        out = std::stoull(digits);
+        return true;
+    }
+
+    std::string pathFor(const char* prefix, uint64_t seq, const char* ext) const {
+        char num[32];
+        std::snprintf(num, sizeof num, "%016llu", static_cast<unsigned long long>(seq));
+        return dir_ + "/" + prefix + num + ext;
+    }
+
+    static bool writeAll(int fd, const std::vector<uint8_t>& bytes) {
+        size_t done = 0;
+        while (done < bytes.size()) {
+            const ssize_t n = ::write(fd, bytes.data() + done, bytes.size() - done);
+            if (n < 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    void closeSegment() {
+        if (segFd_ >= 0) ::close(segFd_);
+        segFd_ = -1;
+    }
+
+    void flushBuffer() {
+        {
+            std::lock_guard<std::mutex> lk(buf_mtx_);
+            if (buf_.empty()) return;
+            out_.swap(buf_);
+        }
+
+        if (segFd_ < 0 || !writeAll(segFd_, out_)) {
+            std::cout << "[JOURNAL] segment write failed, " << out_.size() << " bytes lost\n";
+        } else {
+            ::fdatasync(segFd_);
+            segBytes_ += out_.size();
+        }
+        out_.clear();
+    }
+
+    // Starts segment N, snapshots the state into ckp-N and drops
+    // everything older. Records buffered before the snapshot land in
+    // segment N as well, which replay tolerates.
+    void checkpoint() {
+        namespace fs = std::filesystem;
+
+        const uint64_t seq = nextSeq_++;
+        closeSegment();
+
+        const std::string segPath = pathFor("seg-", seq, ".wal");
+        segFd_ = ::open(segPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        segBytes_ = 0;
+        if (segFd_ < 0) {
+            std::cout << "[JOURNAL] cannot open " << segPath << "\n";
+            return;
+        }
+
+        flushBuffer();
+        {
+            std::lock_guard<std::mutex> lk(buf_mtx_);
+            sinceCheckpoint_ = 0;
+        }
+
+        const State st = provider_ ? provider_() : State{};
+
+        std::vector<uint8_t> bytes;
+        put<uint32_t>(bytes, kCkpMagic);
+        put<uint64_t>(bytes, seq);
+        for (const auto& kv : st) {
+            if (kv.second.hasDesired) encodeRecord(bytes, KIND_DESIRED, kv.first, kv.second.desired);
+            if (kv.second.hasActual)  encodeRecord(bytes, KIND_ACTUAL, kv.first, kv.second.actual);
+        }
+
+        const std::string ckpPath = pathFor("ckp-", seq, ".ckp");
+        const std::string tmpPath = ckpPath + ".tmp";
+
+        const int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        const bool ok = fd >= 0 && writeAll(fd, bytes) && ::fsync(fd) == 0;
+        if (fd >= 0) ::close(fd);
+
+        if (!ok || ::rename(tmpPath.c_str(), ckpPath.c_str()) != 0) {
+            std::cout << "[JOURNAL] checkpoint failed: " << ckpPath << "\n";
+            return;
+        }
+
+        lastCheckpointMs_ = nowMs();
+
+        std::error_code ec;
+        for (const auto& e : fs::directory_iterator(dir_, ec)) {
+            const std::string name = e.path().filename().string();
+            uint64_t s = 0;
+            if ((parseSeq(name, "ckp-", ".ckp", s) || parseSeq(name, "seg-", ".wal", s)) && s < seq) {
+                fs::remove(e.path(), ec);
+            }
+        }
+    }
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> lk(buf_mtx_);
+
+        while (!stopping_) {
+            cv_.wait_for(lk, std::chrono::milliseconds(GH_JOURNAL_SYNC_MS),
+                         [&] { return stopping_; });
+            if (stopping_) break;
+
+            const bool changed = sinceCheckpoint_ > 0;
+            lk.unlock();
+
+            flushBuffer();
+
+            const bool full = segBytes_ >= GH_JOURNAL_SEGMENT_BYTES;
+            const bool due = changed && nowMs() - lastCheckpointMs_ >= GH_JOURNAL_CHECKPOINT_MS;
+            if (full || due) checkpoint();
+
+            lk.lock();
+        }
+    }
+
+    static std::string key(uint8_t kind, const std::string& name) {
+        return std::string(1, static_cast<char>(kind)) + name;
+    }
+
+    static int64_t nowMs() {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    std::string dir_;
+    bool opened_{false};
+    StateProvider provider_;
+
+    // flusher side
+    int segFd_{-1};
+    size_t segBytes_{0};
+    uint64_t nextSeq_{0};
+    int64_t lastCheckpointMs_{0};
+    std::vector<uint8_t> out_;
+
+    // writer side
+    std::mutex buf_mtx_;
+    std::vector<uint8_t> buf_;
+    std::unordered_map<std::string, Part> last_;   // last journaled state per (kind, name)
+    size_t sinceCheckpoint_{0};
+    bool started_{false};
+
+    std::condition_variable cv_;
+    std::thread flusher_;
+    bool stopping_{false};
+};
+
+} // namespace storage
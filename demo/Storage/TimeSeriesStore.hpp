@@ -0,0 +1,604 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "GorillaCodec.hpp"
+#include "MappedFile.hpp"
+
+// ------------------------------------------------------------
+// Flush policy: a series is written as one block when it has
+// GH_TSDB_BLOCK_POINTS points or its oldest point is older than
+// GH_TSDB_MAX_AGE_MS. Few large appends keep SD card wear low.
+// ------------------------------------------------------------
+#ifndef GH_TSDB_BLOCK_POINTS
+#define GH_TSDB_BLOCK_POINTS 1024
+#endif
+
+#ifndef GH_TSDB_MAX_AGE_MS
+#define GH_TSDB_MAX_AGE_MS (10 * 60 * 1000)
+#endif
+
+#ifndef GH_TSDB_CHECK_MS
+#define GH_TSDB_CHECK_MS 1000
+#endif
+
+#ifndef GH_TSDB_FSYNC
+#define GH_TSDB_FSYNC 1
+#endif
+
+// Points appended by SeriesId go through a lock-free ring of this
+// many entries (power of two) and are moved into the per-series
+// buffers by the flusher or by the next query. A full ring falls
+// back to the locked path.
+#ifndef GH_TSDB_INGEST_POINTS
+#define GH_TSDB_INGEST_POINTS 4096
+#endif
+
+namespace storage {
+
+// ------------------------------------------------------------
+// Append-only, compressed time-series store.
+//
+// One file per series (<dir>/<series>.tsb), made of columnar
+// blocks: a fixed header with the block aggregates, then the
+// delta-of-delta timestamp column, then the XOR value column.
+// Aggregate queries use the header alone for blocks that fall
+// completely into one bucket; reads go through mmap.
+// ------------------------------------------------------------
+class TimeSeriesStore final {
+public:
+    struct Point {
+        int64_t stampMs{0};
+        double value{0.0};
+    };
+
+    using SeriesId = uint32_t;
+
+    struct Aggregate {
+        int64_t stampMs{0};   // bucket start
+        double min{0.0};
+        double max{0.0};
+        double sum{0.0};
+        uint64_t count{0};
+
+        double avg() const { return count ? sum / static_cast<double>(count) : 0.0; }
+    };
+
+    static TimeSeriesStore& instance() {
+        static TimeSeriesStore inst;
+        return inst;
+    }
+
+    TimeSeriesStore(const TimeSeriesStore&) = delete;
+    TimeSeriesStore& operator=(const TimeSeriesStore&) = delete;
+
+    ~TimeSeriesStore() { stop(); }
+
+    // ------------------------------------------------------------
+    // Lifecycle
+    // ------------------------------------------------------------
+    // Creates dir and cuts off any torn block left by a crash.
+    void open(const std::string& dir) {
+        namespace fs = std::filesystem;
+
+        std::unique_lock lk(io_mtx_);
+
+        fs::create_directories(dir);
+        dir_ = dir;
+
+        for (const auto& e : fs::directory_iterator(dir_)) {
+            if (e.is_regular_file() && e.path().extension() == ".tsb") {
+                repairTail(e.path().string());
+            }
+        }
+
+        opened_ = true;
+    }
+
+    bool isOpen() const { return opened_.load(); }
+
+    void start() {
+        if (!opened_) throw std::runtime_error("TimeSeriesStore: open() before start()");
+        if (flusher_.joinable()) return;
+
+        stopping_ = false;
+        flusher_ = std::thread(&TimeSeriesStore::flushLoop, this);
+    }
+
+    // Flushes everything still in memory.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lk(pending_mtx_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+
+        if (flusher_.joinable()) flusher_.join();
+        else if (opened_) flushPending(true);
+    }
+
+    // ------------------------------------------------------------
+    // Write side (any thread, cheap: buffered until the flusher runs)
+    // ------------------------------------------------------------
+    void append(const std::string& series, int64_t stampMs, double value) {
+        std::lock_guard<std::mutex> lk(pending_mtx_);
+        drainIngestLocked();
+        pushPendingLocked(series, Point{stampMs, value});
+    }
+
+    // Interns a series name once; the id is valid for the process
+    // lifetime and is what the hot append path takes.
+    SeriesId seriesId(const std::string& series) {
+        std::lock_guard<std::mutex> lk(pending_mtx_);
+
+        auto it = series_ids_.find(series);
+        if (it != series_ids_.end()) return it->second;
+
+        const auto id = static_cast<SeriesId>(series_names_.size());
+        series_names_.push_back(series);
+        series_ids_.emplace(series, id);
+        return id;
+    }
+
+    // No lock, no allocation: one slot of the ingest ring. Safe to
+    // call from several threads and under other locks.
+    void append(SeriesId series, int64_t stampMs, double value) {
+        size_t pos = ingest_head_.load(std::memory_order_relaxed);
+
+        for (;;) {
+            IngestCell& c = ingest_[pos & kIngestMask];
+            const size_t seq = c.seq.load(std::memory_order_acquire);
+            const auto dif = static_cast<std::ptrdiff_t>(seq - pos);
+
+            if (dif == 0) {
+                if (ingest_head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.series = series;
+                    c.point = Point{stampMs, value};
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return;
+                }
+            } else if (dif < 0) {
+                break;   // full
+            } else {
+                pos = ingest_head_.load(std::memory_order_relaxed);
+            }
+        }
+
+        std::lock_guard<std::mutex> lk(pending_mtx_);
+        drainIngestLocked();
+        pushPendingLocked(series_names_[series], Point{stampMs, value});
+    }
+
+    // Writes every pending series now.
+    void flush() { flushPending(true); }
+
+    // ------------------------------------------------------------
+    // Queries
+    // ------------------------------------------------------------
+    std::vector<std::string> listSeries() const {
+        namespace fs = std::filesystem;
+
+        std::vector<std::string> out;
+        {
+            std::shared_lock lk(io_mtx_);
+            if (!dir_.empty() && fs::exists(dir_)) {
+                for (const auto& e : fs::directory_iterator(dir_)) {
+                    if (e.is_regular_file() && e.path().extension() == ".tsb")
+                        out.push_back(e.path().stem().string());
+                }
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lk(pending_mtx_);
+            drainIngestLocked();
+            for (const auto& kv : pending_) out.push_back(kv.first);
+        }
+
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    // Raw points in [fromMs, toMs], oldest first. With limit > 0 only
+    // the newest limit points are returned.
+    std::vector<Point> query(const std::string& series, int64_t fromMs, int64_t toMs,
+                             size_t limit = 0) const {
+        std::vector<Point> out;
+
+        scanBlocks(series, fromMs, toMs, [&](const BlockHeader& h, const uint8_t* payload) {
+            decodeBlock(h, payload, [&](const Point& p) {
+                if (p.stampMs >= fromMs && p.stampMs <= toMs) out.push_back(p);
+            });
+            return true;
+        });
+
+        for (const auto& p : pendingCopy(series)) {
+            if (p.stampMs >= fromMs && p.stampMs <= toMs) out.push_back(p);
+        }
+
+        std::stable_sort(out.begin(), out.end(),
+                         [](const Point& a, const Point& b) { return a.stampMs < b.stampMs; });
+
+        if (limit > 0 && out.size() > limit) {
+            out.erase(out.begin(), out.end() - static_cast<std::ptrdiff_t>(limit));
+        }
+        return out;
+    }
+
+    // min/max/avg per stepMs bucket (aligned to unix epoch) in
+    // [fromMs, toMs]; stepMs == 0 gives a single bucket.
+    std::vector<Aggregate> aggregate(const std::string& series, int64_t fromMs, int64_t toMs,
+                                     int64_t stepMs) const {
+        std::vector<Aggregate> buckets;
+
+        auto bucketStart = [&](int64_t t) -> int64_t {
+            if (stepMs <= 0) return fromMs;
+            return t - (((t % stepMs) + stepMs) % stepMs);
+        };
+
+        auto bucketFor = [&](int64_t start) -> Aggregate& {
+            // points arrive mostly in order, so the last bucket is the hot one
+            if (!buckets.empty() && buckets.back().stampMs == start) return buckets.back();
+
+            auto it = std::lower_bound(buckets.begin(), buckets.end(), start,
+                [](const Aggregate& a, int64_t s) { return a.stampMs < s; });
+            if (it != buckets.end() && it->stampMs == start) return *it;
+
+            Aggregate a;
+            a.stampMs = start;
+            a.min = std::numeric_limits<double>::infinity();
+            a.max = -std::numeric_limits<double>::infinity();
+            return *buckets.insert(it, a);
+        };
+
+        auto addPoint = [&](const Point& p) {
+            if (p.stampMs < fromMs || p.stampMs > toMs) return;
+
+            Aggregate& a = bucketFor(bucketStart(p.stampMs));
+            a.min = std::min(a.min, p.value);
+            a.max = std::max(a.max, p.value);
+            a.sum += p.value;
+            a.count += 1;
+        };
+
+        scanBlocks(series, fromMs, toMs, [&](const BlockHeader& h, const uint8_t* payload) {
+            const bool inside = h.firstMs >= fromMs && h.lastMs <= toMs;
+            const bool oneBucket = bucketStart(h.firstMs) == bucketStart(h.lastMs);
+
+            if (inside && oneBucket) {
+                // header aggregates are enough, no decoding
+                Aggregate& a = bucketFor(bucketStart(h.firstMs));
+                a.min = std::min(a.min, h.minValue);
+                a.max = std::max(a.max, h.maxValue);
+                a.sum += h.sum;
+                a.count += h.count;
+            } else {
+                decodeBlock(h, payload, addPoint);
+            }
+            return true;
+        });
+
+        for (const auto& p : pendingCopy(series)) addPoint(p);
+
+        return buckets;
+    }
+
+private:
+    TimeSeriesStore() = default;
+
+    // ------------------------------------------------------------
+    // On-disk block
+    // ------------------------------------------------------------
+    static constexpr uint32_t kBlockMagic = 0x53544847;   // "GHTS"
+    static constexpr uint16_t kBlockVersion = 1;
+
+    struct BlockHeader {
+        uint32_t magic{kBlockMagic};
+        uint16_t version{kBlockVersion};
+        uint16_t flags{0};
+        uint32_t count{0};
+        uint32_t tsBytes{0};
+        uint32_t valueBytes{0};
+        uint32_t reserved{0};
+        int64_t firstMs{0};
+        int64_t lastMs{0};
+        double minValue{0.0};
+        double maxValue{0.0};
+        double sum{0.0};
+    };
+    static_assert(sizeof(BlockHeader) == 64, "BlockHeader layout");
+
+    struct Pending {
+        std::vector<Point> points;
+        int64_t firstAtMs{0};
+    };
+
+    static constexpr size_t kIngestSize = GH_TSDB_INGEST_POINTS;
+    static constexpr size_t kIngestMask = kIngestSize - 1;
+    static_assert(kIngestSize >= 2 && (kIngestSize & kIngestMask) == 0,
+                  "GH_TSDB_INGEST_POINTS must be a power of two");
+
+    // bounded MPSC ring cell; seq == pos + 1 once written for pos
+    struct IngestCell {
+        std::atomic<size_t> seq{0};
+        SeriesId series{0};
+        Point point;
+    };
+
+    static std::unique_ptr<IngestCell[]> makeIngestRing() {
+        std::unique_ptr<IngestCell[]> ring(new IngestCell[kIngestSize]);
+        for (size_t i = 0; i < kIngestSize; ++i) ring[i].seq.store(i, std::memory_order_relaxed);
+        return ring;
+    }
+
+    static bool validBlock(const BlockHeader& h, size_t remaining) {
+        return h.magic == kBlockMagic &&
+               h.version == kBlockVersion &&
+               h.count > 0 &&
+               sizeof(BlockHeader) + static_cast<size_t>(h.tsBytes) + h.valueBytes <= remaining;
+    }
+
+    // ------------------------------------------------------------
+    // Encoding
+    // ------------------------------------------------------------
+    // points must be sorted by stamp
+    static std::vector<uint8_t> encodeBlock(const std::vector<Point>& points) {
+        BlockHeader h;
+        h.count = static_cast<uint32_t>(points.size());
+        h.firstMs = points.front().stampMs;
+        h.lastMs = points.back().stampMs;
+        h.minValue = points.front().value;
+        h.maxValue = points.front().value;
+
+        TimestampEncoder ts(h.firstMs);
+        ValueEncoder vals;
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (i > 0) ts.add(points[i].stampMs);
+            vals.add(points[i].value);
+
+            h.minValue = std::min(h.minValue, points[i].value);
+            h.maxValue = std::max(h.maxValue, points[i].value);
+            h.sum += points[i].value;
+        }
+
+        h.tsBytes = static_cast<uint32_t>(ts.bytes().size());
+        h.valueBytes = static_cast<uint32_t>(vals.bytes().size());
+
+        std::vector<uint8_t> out(sizeof(BlockHeader) + h.tsBytes + h.valueBytes);
+        std::memcpy(out.data(), &h, sizeof h);
+        if (h.tsBytes)
+            std::memcpy(out.data() + sizeof h, ts.bytes().data(), h.tsBytes);
+        std::memcpy(out.data() + sizeof h + h.tsBytes, vals.bytes().data(), h.valueBytes);
+        return out;
+    }
+
+    template<class Fn>
+    static void decodeBlock(const BlockHeader& h, const uint8_t* payload, Fn&& fn) {
+        TimestampDecoder ts(h.firstMs, payload, h.tsBytes);
+        ValueDecoder vals(payload + h.tsBytes, h.valueBytes);
+
+        for (uint32_t i = 0; i < h.count; ++i) {
+            Point p;
+            p.stampMs = (i == 0) ? h.firstMs : ts.next();
+            p.value = vals.next();
+            fn(p);
+        }
+    }
+
+    // ------------------------------------------------------------
+    // Reading
+    // ------------------------------------------------------------
+    // Calls fn(header, payload) for every block overlapping the range.
+    template<class Fn>
+    void scanBlocks(const std::string& series, int64_t fromMs, int64_t toMs, Fn&& fn) const {
+        std::shared_lock lk(io_mtx_);
+        if (dir_.empty()) return;
+
+        MappedFile f(pathFor(series));
+        if (!f.data) return;
+
+        size_t off = 0;
+        while (off + sizeof(BlockHeader) <= f.size) {
+            BlockHeader h;
+            std::memcpy(&h, f.data + off, sizeof h);
+            if (!validBlock(h, f.size - off)) break;
+
+            const uint8_t* payload = f.data + off + sizeof h;
+            off += sizeof h + h.tsBytes + h.valueBytes;
+
+            if (h.lastMs < fromMs || h.firstMs > toMs) continue;
+            if (!fn(h, payload)) break;
+        }
+    }
+
+    // ------------------------------------------------------------
+    // Write buffers (caller holds pending_mtx_)
+    // ------------------------------------------------------------
+    void pushPendingLocked(const std::string& series, const Point& p) const {
+        auto& pend = pending_[series];
+        if (pend.points.empty()) {
+            pend.points.reserve(GH_TSDB_BLOCK_POINTS);
+            pend.firstAtMs = p.stampMs;
+        }
+        pend.points.push_back(p);
+    }
+
+    // single consumer: pending_mtx_ serializes the drains
+    void drainIngestLocked() const {
+        for (;;) {
+            IngestCell& c = ingest_[ingest_tail_ & kIngestMask];
+            if (c.seq.load(std::memory_order_acquire) != ingest_tail_ + 1) return;
+
+            pushPendingLocked(series_names_[c.series], c.point);
+            c.seq.store(ingest_tail_ + kIngestSize, std::memory_order_release);
+            ++ingest_tail_;
+        }
+    }
+
+    std::vector<Point> pendingCopy(const std::string& series) const {
+        std::lock_guard<std::mutex> lk(pending_mtx_);
+        drainIngestLocked();
+
+        auto it = pending_.find(series);
+        if (it == pending_.end()) return {};
+        return it->second.points;
+    }
+
+    // ------------------------------------------------------------
+    // Writing
+    // ------------------------------------------------------------
+    std::string pathFor(const std::string& series) const {
+        std::string name;
+        name.reserve(series.size());
+        for (char c : series) {
+            const bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                            (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.';
+            name += ok ? c : '_';
+        }
+        return dir_ + "/" + name + ".tsb";
+    }
+
+    // io_mtx_ held exclusively
+    static void repairTail(const std::string& path) {
+        size_t good = 0;
+        {
+            MappedFile f(path);
+            if (!f.data) return;
+
+            while (good + sizeof(BlockHeader) <= f.size) {
+                BlockHeader h;
+                std::memcpy(&h, f.data + good, sizeof h);
+                if (!validBlock(h, f.size - good)) break;
+                good += sizeof h + h.tsBytes + h.valueBytes;
+            }
+
+            if (good == f.size) return;
+        }
+
+        std::cout << "[TSDB] truncating torn tail of " << path << "\n";
+        if (::truncate(path.c_str(), static_cast<off_t>(good)) != 0) {
+            std::cout << "[TSDB] truncate failed for " << path << "\n";
+        }
+    }
+
+    void writeBlock(const std::string& series, std::vector<Point>& points) {
+        std::stable_sort(points.begin(), points.end(),
+                         [](const Point& a, const Point& b) { return a.stampMs < b.stampMs; });
+
+        const auto bytes = encodeBlock(points);
+        const std::string path = pathFor(series);
+
+        std::unique_lock lk(io_mtx_);
+
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) throw std::runtime_error("TimeSeriesStore: cannot open " + path);
+
+        size_t done = 0;
+        while (done < bytes.size()) {
+            const ssize_t n = ::write(fd, bytes.data() + done, bytes.size() - done);
+            if (n < 0) {
+                ::close(fd);
+                throw std::runtime_error("TimeSeriesStore: write failed for " + path);
+            }
+            done += static_cast<size_t>(n);
+        }
+
+#if GH_TSDB_FSYNC
+        ::fdatasync(fd);
+#endif
+        ::close(fd);
+    }
+
+    void flushPending(bool all) {
+        std::vector<std::pair<std::string, std::vector<Point>>> ready;
+        {
+            std::lock_guard<std::mutex> lk(pending_mtx_);
+            drainIngestLocked();
+            const int64_t now = nowMs();
+
+            for (auto it = pending_.begin(); it != pending_.end();) {
+                const auto& p = it->second;
+                const bool full = p.points.size() >= GH_TSDB_BLOCK_POINTS;
+                const bool old = now - p.firstAtMs >= GH_TSDB_MAX_AGE_MS;
+
+                if (!p.points.empty() && (all || full || old)) {
+                    ready.emplace_back(it->first, std::move(it->second.points));
+                    it = pending_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        for (auto& kv : ready) {
+            try {
+                writeBlock(kv.first, kv.second);
+            } catch (const std::exception& ex) {
+                std::cout << "[TSDB] " << ex.what() << "\n";
+            }
+        }
+    }
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> lk(pending_mtx_);
+
+        while (!stopping_) {
+            cv_.wait_for(lk, std::chrono::milliseconds(GH_TSDB_CHECK_MS),
+                         [&] { return stopping_; });
+
+            const bool last = stopping_;
+            lk.unlock();
+            flushPending(last);
+            lk.lock();
+        }
+    }
+
+    static int64_t nowMs() {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    std::string dir_;
+    std::atomic<bool> opened_{false};
+
+    // exclusive while appending to a file, shared while mapping one
+    mutable std::shared_mutex io_mtx_;
+
+    // queries drain the ingest ring too, hence mutable
+    mutable std::mutex pending_mtx_;
+    mutable std::unordered_map<std::string, Pending> pending_;
+
+    std::vector<std::string> series_names_;   // by SeriesId
+    std::unordered_map<std::string, SeriesId> series_ids_;
+
+    std::unique_ptr<IngestCell[]> ingest_{makeIngestRing()};
+    std::atomic<size_t> ingest_head_{0};
+    mutable size_t ingest_tail_{0};
+
+    std::condition_variable cv_;
+    std::thread flusher_;
+    bool stopping_{false};
+};
+
+} // namespace storage
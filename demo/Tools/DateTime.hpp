@@ -6,6 +6,8 @@
 #include <sstream>
 #include <string>
 
+#include "VirtualClock.hpp"
+
 namespace tools {
 
 struct UnixMs {
@@ -25,15 +27,20 @@ struct DateTime {
     int second{};
     int millisecond{};
 
+    int dayOfYear{};    // 1..366
+
     long long unixMs{};
 };
 
 // ------------------------------------------------------------
-// get current unix ms
+// get current unix ms (simulated when VirtualClock is enabled)
 // ------------------------------------------------------------
 inline long long nowUnixMs() {
     using namespace std::chrono;
 
+    const auto& vc = VirtualClock::instance();
+    if (vc.enabled()) return vc.unixMs();
+
     return duration_cast<milliseconds>(
         system_clock::now().time_since_epoch()
     ).count();
@@ -67,6 +74,8 @@ inline DateTime fromUnixMs(long long unixMs) {
     dt.minute = local_tm.tm_min;
     dt.second = local_tm.tm_sec;
 
+    dt.dayOfYear = local_tm.tm_yday + 1;
+
     dt.millisecond = static_cast<int>(unixMs % 1000);
     if (dt.millisecond < 0) dt.millisecond += 1000;
 
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tools {
+
+// ------------------------------------------------------------
+// Fork-join helper for splitting one call into independent jobs.
+// run(jobs, fn) calls fn(0 .. jobs-1) on the helper threads and on
+// the calling thread, and returns when every job returned. Threads
+// claim the next unclaimed job from a shared counter, so a slow job
+// never holds up the others. No allocation per run.
+// One run() at a time.
+// ------------------------------------------------------------
+class ForkJoinPool final {
+public:
+    explicit ForkJoinPool(std::size_t helpers) {
+        threads_.reserve(helpers);
+        for (std::size_t i = 0; i < helpers; ++i) {
+            threads_.emplace_back(&ForkJoinPool::loop, this);
+        }
+    }
+
+    ~ForkJoinPool() {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    ForkJoinPool(const ForkJoinPool&) = delete;
+    ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+
+    std::size_t helpers() const { return threads_.size(); }
+
+    // Rethrows the first exception a job threw, after all returned.
+    template<class Fn>
+    void run(std::size_t jobs, Fn& fn) {
+        if (jobs == 0) return;
+
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            fn_ = &fn;
+            call_ = &invoke<Fn>;
+            jobs_ = jobs;
+            done_ = 0;
+            error_ = nullptr;
+            next_.store(0, std::memory_order_relaxed);
+            open_ = true;
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        work(&fn, &invoke<Fn>, jobs);
+
+        std::exception_ptr err;
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            idle_.wait(lk, [&] { return done_ == jobs_ && active_ == 0; });
+            open_ = false;   // helpers that wake late do not join
+            err = error_;
+        }
+        if (err) std::rethrow_exception(err);
+    }
+
+private:
+    using Call = void (*)(void*, std::size_t);
+
+    template<class Fn>
+    static void invoke(void* fn, std::size_t i) { (*static_cast<Fn*>(fn))(i); }
+
+    void work(void* fn, Call call, std::size_t jobs) {
+        for (;;) {
+            const std::size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+            if (i >= jobs) return;
+
+            std::exception_ptr err;
+            try {
+                call(fn, i);
+            } catch (...) {
+                err = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (err && !error_) error_ = err;
+            if (++done_ == jobs_) idle_.notify_all();
+        }
+    }
+
+    void loop() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lk(mtx_);
+
+        for (;;) {
+            wake_.wait(lk, [&] { return stop_ || (open_ && generation_ != seen); });
+            if (stop_) return;
+
+            // job taken under the lock, so it belongs to this run
+            seen = generation_;
+            void* fn = fn_;
+            const Call call = call_;
+            const std::size_t jobs = jobs_;
+            ++active_;
+
+            lk.unlock();
+            work(fn, call, jobs);
+            lk.lock();
+
+            if (--active_ == 0) idle_.notify_all();
+        }
+    }
+
+    std::vector<std::thread> threads_;
+
+    std::mutex mtx_;
+    std::condition_variable wake_;   // helpers: a run started or stop
+    std::condition_variable idle_;   // caller: jobs done, helpers out
+
+    // current run, written under mtx_
+    void* fn_{nullptr};
+    Call call_{nullptr};
+    std::size_t jobs_{0};
+    std::size_t done_{0};
+    std::size_t active_{0};
+    uint64_t generation_{0};
+    bool open_{false};
+    bool stop_{false};
+    std::exception_ptr error_;
+
+    std::atomic<std::size_t> next_{0};
+};
+
+} // namespace tools
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// ------------------------------------------------------------
+// Capacities (points per series per tier), all preallocated
+// ------------------------------------------------------------
+#ifndef GH_HISTORY_RAW_CAP
+#define GH_HISTORY_RAW_CAP 512      // raw samples
+#endif
+
+#ifndef GH_HISTORY_SEC_CAP
+#define GH_HISTORY_SEC_CAP 900      // 1 s buckets, 15 min
+#endif
+
+#ifndef GH_HISTORY_MIN_CAP
+#define GH_HISTORY_MIN_CAP 1440     // 1 min buckets, 1 day
+#endif
+
+#ifndef GH_HISTORY_HOUR_CAP
+#define GH_HISTORY_HOUR_CAP 720     // 1 h buckets, 30 days
+#endif
+
+#ifndef GH_HISTORY_MAX_SERIES
+#define GH_HISTORY_MAX_SERIES 64    // getter slots that can keep history
+#endif
+
+namespace tools {
+
+enum class HistoryTier : uint8_t { RAW = 0, SEC = 1, MIN = 2, HOUR = 3 };
+
+constexpr size_t kHistoryTiers = 4;
+
+inline const char* toString(HistoryTier t) {
+    switch (t) {
+        case HistoryTier::RAW:  return "raw";
+        case HistoryTier::SEC:  return "1s";
+        case HistoryTier::MIN:  return "1m";
+        case HistoryTier::HOUR: return "1h";
+    }
+    return "raw";
+}
+
+inline long long historyBucketMs(HistoryTier t) {
+    switch (t) {
+        case HistoryTier::RAW:  return 0;
+        case HistoryTier::SEC:  return 1000;
+        case HistoryTier::MIN:  return 60 * 1000;
+        case HistoryTier::HOUR: return 60 * 60 * 1000;
+    }
+    return 0;
+}
+
+// raw samples have min == max == avg and count 1;
+// rollups are stamped with the bucket start (unix ms)
+struct HistoryPoint {
+    long long stampMs{0};
+    double min{0.0};
+    double max{0.0};
+    double avg{0.0};
+    uint32_t count{0};
+};
+
+// ------------------------------------------------------------
+// Fixed-size ring of points: one writer, any number of readers,
+// no locks and no allocation after construction.
+//
+// The writer announces the index it is about to overwrite in
+// writing_, fills the slot, then publishes it through head_.
+// Readers copy a range and afterwards drop every index the writer
+// may have touched meanwhile (seqlock-style validation).
+// ------------------------------------------------------------
+class HistoryRing {
+public:
+    explicit HistoryRing(size_t capacity)
+        : cap_(capacity == 0 ? 1 : capacity), slots_(new Slot[cap_]) {}
+
+    HistoryRing(const HistoryRing&) = delete;
+    HistoryRing& operator=(const HistoryRing&) = delete;
+
+    size_t capacity() const { return cap_; }
+
+    size_t size() const {
+        return static_cast<size_t>(std::min<uint64_t>(head_.load(std::memory_order_acquire), cap_));
+    }
+
+    // writer only
+    void push(const HistoryPoint& p) {
+        const uint64_t h = head_.load(std::memory_order_relaxed);
+
+        writing_.store(h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Slot& s = slots_[h % cap_];
+        s.stampMs.store(p.stampMs, std::memory_order_relaxed);
+        s.min.store(p.min, std::memory_order_relaxed);
+        s.max.store(p.max, std::memory_order_relaxed);
+        s.avg.store(p.avg, std::memory_order_relaxed);
+        s.count.store(p.count, std::memory_order_relaxed);
+
+        head_.store(h + 1, std::memory_order_release);
+    }
+
+    // Points with fromMs <= stamp <= toMs, oldest first, at most limit
+    // (the newest ones are kept). limit == 0 means no limit.
+    void query(long long fromMs, long long toMs, size_t limit,
+               std::vector<HistoryPoint>& out) const {
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        const uint64_t begin = head > cap_ ? head - cap_ : 0;
+
+        const size_t first = out.size();
+
+        for (uint64_t i = begin; i < head; ++i) {
+            const Slot& s = slots_[i % cap_];
+
+            HistoryPoint p;
+            p.stampMs = s.stampMs.load(std::memory_order_relaxed);
+            p.min = s.min.load(std::memory_order_relaxed);
+            p.max = s.max.load(std::memory_order_relaxed);
+            p.avg = s.avg.load(std::memory_order_relaxed);
+            p.count = s.count.load(std::memory_order_relaxed);
+
+            out.push_back(p);
+        }
+
+        // anything at or below writing - cap may have been overwritten
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t writing = writing_.load(std::memory_order_relaxed);
+        const uint64_t valid = writing > cap_ ? writing - cap_ : 0;
+
+        const size_t torn = static_cast<size_t>(valid > begin ? valid - begin : 0);
+        const auto copiedEnd = out.begin() + static_cast<std::ptrdiff_t>(first);
+        out.erase(copiedEnd, copiedEnd + static_cast<std::ptrdiff_t>(std::min(torn, out.size() - first)));
+
+        out.erase(std::remove_if(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(),
+                                 [&](const HistoryPoint& p) {
+                                     return p.stampMs < fromMs || p.stampMs > toMs;
+                                 }),
+                  out.end());
+
+        if (limit > 0 && out.size() - first > limit) {
+            out.erase(out.begin() + static_cast<std::ptrdiff_t>(first),
+                      out.end() - static_cast<std::ptrdiff_t>(limit));
+        }
+    }
+
+    // stamp of the oldest retained point, or -1 if empty
+    long long oldestMs() const {
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        if (head == 0) return -1;
+
+        const uint64_t begin = head > cap_ ? head - cap_ : 0;
+        return slots_[begin % cap_].stampMs.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<long long> stampMs{0};
+        std::atomic<double> min{0.0};
+        std::atomic<double> max{0.0};
+        std::atomic<double> avg{0.0};
+        std::atomic<uint32_t> count{0};
+    };
+
+    const size_t cap_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> head_{0};     // published points
+    std::atomic<uint64_t> writing_{0};  // index being written + 1
+};
+
+// ------------------------------------------------------------
+// History of one numeric getter: raw ring plus 1 s / 1 min / 1 h
+// min-max-avg rollups. Each rollup tier is fed by the closed
+// buckets of the tier below it; a bucket is published when the
+// first point of the next bucket arrives.
+// ------------------------------------------------------------
+class HistorySeries {
+public:
+    HistorySeries()
+        : rings_{{
+              std::make_unique<HistoryRing>(GH_HISTORY_RAW_CAP),
+              std::make_unique<HistoryRing>(GH_HISTORY_SEC_CAP),
+              std::make_unique<HistoryRing>(GH_HISTORY_MIN_CAP),
+              std::make_unique<HistoryRing>(GH_HISTORY_HOUR_CAP),
+          }} {}
+
+    // writer only
+    void push(long long stampMs, double v) {
+        HistoryPoint p;
+        p.stampMs = stampMs;
+        p.min = v;
+        p.max = v;
+        p.avg = v;
+        p.count = 1;
+
+        rings_[0]->push(p);
+        feed(1, p);
+    }
+
+    const HistoryRing& ring(HistoryTier t) const {
+        return *rings_[static_cast<size_t>(t)];
+    }
+
+    // Finest tier that still covers fromMs, or the coarsest one.
+    HistoryTier pickTier(long long fromMs) const {
+        for (size_t i = 0; i < kHistoryTiers; ++i) {
+            const long long oldest = rings_[i]->oldestMs();
+            if (oldest >= 0 && oldest <= fromMs) return static_cast<HistoryTier>(i);
+        }
+        return HistoryTier::HOUR;
+    }
+
+    std::vector<HistoryPoint> query(HistoryTier t, long long fromMs, long long toMs,
+                                    size_t limit = 0) const {
+        std::vector<HistoryPoint> out;
+        ring(t).query(fromMs, toMs, limit, out);
+        return out;
+    }
+
+private:
+    struct Bucket {
+        long long startMs{-1};
+        double min{0.0};
+        double max{0.0};
+        double sum{0.0};
+        uint32_t count{0};
+    };
+
+    void feed(size_t tier, const HistoryPoint& p) {
+        if (tier >= kHistoryTiers) return;
+
+        const long long width = historyBucketMs(static_cast<HistoryTier>(tier));
+        const long long start = p.stampMs - (((p.stampMs % width) + width) % width);
+
+        Bucket& b = open_[tier - 1];
+
+        if (b.count > 0 && b.startMs != start) {
+            HistoryPoint closed;
+            closed.stampMs = b.startMs;
+            closed.min = b.min;
+            closed.max = b.max;
+            closed.avg = b.sum / b.count;
+            closed.count = b.count;
+
+            rings_[tier]->push(closed);
+            feed(tier + 1, closed);
+
+            b = Bucket{};
+        }
+
+        if (b.count == 0) {
+            b.startMs = start;
+            b.min = p.min;
+            b.max = p.max;
+        } else {
+            b.min = std::min(b.min, p.min);
+            b.max = std::max(b.max, p.max);
+        }
+        b.sum += p.avg * p.count;
+        b.count += p.count;
+    }
+
+    std::array<std::unique_ptr<HistoryRing>, kHistoryTiers> rings_;
+    std::array<Bucket, kHistoryTiers - 1> open_{};  // writer-local, SEC..HOUR
+};
+
+// ------------------------------------------------------------
+// Series indexed by getter slot. attach() is writer side and
+// allocates once per slot; series() is safe from any thread.
+// ------------------------------------------------------------
+class HistoryStore {
+public:
+    // nullptr if slot is beyond GH_HISTORY_MAX_SERIES
+    HistorySeries* attach(uint32_t slot) {
+        if (slot >= series_.size()) return nullptr;
+
+        HistorySeries* s = series_[slot].load(std::memory_order_acquire);
+        if (s) return s;
+
+        owned_.push_back(std::make_unique<HistorySeries>());
+        s = owned_.back().get();
+        series_[slot].store(s, std::memory_order_release);
+        return s;
+    }
+
+    const HistorySeries* series(uint32_t slot) const {
+        if (slot >= series_.size()) return nullptr;
+        return series_[slot].load(std::memory_order_acquire);
+    }
+
+    HistorySeries* seriesMut(uint32_t slot) {
+        if (slot >= series_.size()) return nullptr;
+        return series_[slot].load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<std::atomic<HistorySeries*>, GH_HISTORY_MAX_SERIES> series_{};
+    std::vector<std::unique_ptr<HistorySeries>> owned_;   // writer only
+};
+
+} // namespace tools
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace tools {
+
+// ------------------------------------------------------------
+// Lock-free log-linear histogram of non-negative integers
+// (microseconds in practice).
+//
+// Values below 16 get one bucket each; above that every power
+// of two is split into 16 linear sub-buckets, so a reported
+// quantile is within ~6% of the true value. Values past 2^40
+// land in the last bucket. record() is a few relaxed atomics;
+// readers may see a sample counted in one field but not yet in
+// another, which is fine for monitoring.
+// ------------------------------------------------------------
+class LogLinearHistogram {
+public:
+    static constexpr int    kSubBits    = 4;
+    static constexpr int    kMaxBit     = 40;
+    static constexpr size_t kSubBuckets = size_t{1} << kSubBits;
+    static constexpr size_t kBuckets    = (kMaxBit - kSubBits + 2) * kSubBuckets;
+
+    struct Summary {
+        uint64_t count{0};
+        uint64_t p50{0};
+        uint64_t p90{0};
+        uint64_t p99{0};
+        uint64_t max{0};
+        double   mean{0.0};
+    };
+
+    void record(uint64_t v) {
+        counts_[bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(v, std::memory_order_relaxed);
+
+        uint64_t m = max_.load(std::memory_order_relaxed);
+        while (v > m && !max_.compare_exchange_weak(m, v, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding quantile q (0..1), clamped to max.
+    uint64_t quantile(double q) const {
+        std::array<uint64_t, kBuckets> c;
+        uint64_t total = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            c[i] = counts_[i].load(std::memory_order_relaxed);
+            total += c[i];
+        }
+        return quantileOf(c, total, q);
+    }
+
+    Summary summary() const {
+        std::array<uint64_t, kBuckets> c;
+        uint64_t total = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            c[i] = counts_[i].load(std::memory_order_relaxed);
+            total += c[i];
+        }
+
+        Summary s;
+        s.count = total;
+        s.max = max();
+        if (total == 0) return s;
+
+        s.p50 = quantileOf(c, total, 0.50);
+        s.p90 = quantileOf(c, total, 0.90);
+        s.p99 = quantileOf(c, total, 0.99);
+        s.mean = static_cast<double>(sum_.load(std::memory_order_relaxed)) /
+                 static_cast<double>(total);
+        return s;
+    }
+
+    // Not atomic with respect to concurrent record() calls.
+    void reset() {
+        for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    static size_t bucketOf(uint64_t v) {
+        if (v < kSubBuckets) return static_cast<size_t>(v);
+
+        int msb = 63 - __builtin_clzll(v);
+        if (msb > kMaxBit) return kBuckets - 1;
+
+        const size_t sub = static_cast<size_t>(v >> (msb - kSubBits)) & (kSubBuckets - 1);
+        return static_cast<size_t>(msb - kSubBits + 1) * kSubBuckets + sub;
+    }
+
+    // Largest value that maps to bucket i.
+    static uint64_t bucketUpper(size_t i) {
+        if (i < kSubBuckets) return i;
+
+        const int msb = static_cast<int>(i / kSubBuckets) + kSubBits - 1;
+        const uint64_t sub = i % kSubBuckets;
+        const uint64_t lo = (uint64_t{1} << msb) | (sub << (msb - kSubBits));
+        return lo + (uint64_t{1} << (msb - kSubBits)) - 1;
+    }
+
+private:
+    uint64_t quantileOf(const std::array<uint64_t, kBuckets>& c, uint64_t total, double q) const {
+        if (total == 0) return 0;
+
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > total) rank = total;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += c[i];
+            if (seen >= rank) {
+                const uint64_t up = bucketUpper(i);
+                const uint64_t m = max();
+                return up < m ? up : m;
+            }
+        }
+        return max();
+    }
+
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+} // namespace tools
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+namespace tools {
+
+// ------------------------------------------------------------
+// Process-wide simulated time.
+//
+// Off by default: every clock reader (tools::nowUnixMs(),
+// GH_GlobalState::nowMs(), Scheduler) uses the real clocks.
+// Once enabled it stays on; time then starts at startUnixMs and
+// only moves when advanceTo() is called, which is done by the
+// Scheduler when all of its work for the current instant has
+// returned. The steady clock continues from its real value at
+// enable(), so relative stamps stay monotonic.
+// ------------------------------------------------------------
+class VirtualClock {
+public:
+    static VirtualClock& instance() {
+        static VirtualClock inst;
+        return inst;
+    }
+
+    void enable(long long startUnixMs) {
+        using namespace std::chrono;
+        if (enabled()) throw std::runtime_error("VirtualClock: already enabled");
+
+        startUnixMs_ = startUnixMs;
+        startSteadyMs_ = static_cast<uint64_t>(
+            duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+        elapsedMs_.store(0, std::memory_order_relaxed);
+        enabled_.store(true, std::memory_order_release);
+    }
+
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    // simulated ms since enable()
+    uint64_t elapsedMs() const { return elapsedMs_.load(std::memory_order_acquire); }
+
+    long long unixMs() const { return startUnixMs_ + static_cast<long long>(elapsedMs()); }
+    uint64_t  steadyMs() const { return startSteadyMs_ + elapsedMs(); }
+
+    // Never moves backwards.
+    void advanceTo(uint64_t elapsedMs) {
+        uint64_t cur = elapsedMs_.load(std::memory_order_relaxed);
+        while (elapsedMs > cur &&
+               !elapsedMs_.compare_exchange_weak(cur, elapsedMs, std::memory_order_release)) {
+        }
+    }
+
+    VirtualClock(const VirtualClock&) = delete;
+    VirtualClock& operator=(const VirtualClock&) = delete;
+
+private:
+    VirtualClock() = default;
+
+    std::atomic<bool>     enabled_{false};
+    std::atomic<uint64_t> elapsedMs_{0};
+    long long             startUnixMs_{0};
+    uint64_t              startSteadyMs_{0};
+};
+
+} // namespace tools
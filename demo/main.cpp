@@ -1,8 +1,13 @@
 #include <iostream>
 #include <thread>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <climits>
+#include <limits>
 #include <csignal>
 #include <memory>
+#include <mutex>
 #include <any>
 #include <type_traits>
 #include <string>
@@ -14,6 +19,7 @@
 #include "GlobalState.hpp"
 #include "Configurator.hpp"
 #include "Scheduler/Scheduler.hpp"
+#include "Scheduler/TaskGraph.hpp"
 #include "DataGetter/DataGetter.hpp"
 #include "DataGetter/DG_DS18B20.hpp"
 #include "DataGetter/DG_OWM_Weather.hpp"
@@ -22,6 +28,8 @@
 #include "DataGetter/DG_SYS_DISK.hpp"
 #include "DataGetter/DG_SYS_TIME.hpp"
 #include "API/HttpServer.hpp"
+#include "Storage/TimeSeriesStore.hpp"
+#include "Storage/StateJournal.hpp"
 
 #include "Executor/Executor.hpp"
 #include "Executor/EX_DeviceControlModule.hpp"
@@ -32,24 +40,74 @@
 #include "Logic/LogicJsonController.hpp"
 #include "API/JsonAPI.hpp"   // если у тебя файл называется JsonApi.hpp -> поменяй include
 #include "Logic/LogicDebugJson.hpp"
+#include "API/HistoryJson.hpp"
+#include "API/LogicProfileJson.hpp"
+#include "API/SchedulerJson.hpp"
+
+// ------------------------------------------------------------
+// Control lane: SCHED_FIFO priority (0 = normal scheduling) and
+// cores to pin to, e.g. -DGH_CONTROL_LANE_CPUS={3}
+// ------------------------------------------------------------
+#ifndef GH_CONTROL_LANE_FIFO
+#define GH_CONTROL_LANE_FIFO 20
+#endif
+
+#ifndef GH_CONTROL_LANE_CPUS
+#define GH_CONTROL_LANE_CPUS {}
+#endif
+
+// ------------------------------------------------------------
+// Logic tick threads (1 = single-threaded) and the rule count
+// below which a tick stays single-threaded
+// ------------------------------------------------------------
+#ifndef GH_LOGIC_THREADS
+#define GH_LOGIC_THREADS 1
+#endif
+
+#ifndef GH_LOGIC_PARALLEL_MIN
+#define GH_LOGIC_PARALLEL_MIN 512
+#endif
+
+// ------------------------------------------------------------
+// Logic profiler at startup (0 = off); POST logic/profile
+// switches it at runtime
+// ------------------------------------------------------------
+#ifndef GH_LOGIC_PROFILE
+#define GH_LOGIC_PROFILE 0
+#endif
 
 // ------------------------------------------------------------
 // Adapter: Field<T> -> GH_GlobalState getter map
 // ------------------------------------------------------------
 template<typename T>
 struct Field {
-    explicit Field(std::string key) : key_(std::move(key)) {}
+    using Value = GH_GlobalState::Value;
+
+    // the key is interned once, DataGetter ticks write by handle
+    explicit Field(std::string key)
+        : key_(std::move(key)),
+          handle_(GH_GlobalState::instance().registerGetter(key_, valueType())) {}
 
     void set(const T& v) {
         if constexpr (std::is_same_v<T, float>) {
-            GH_GlobalState::instance().setGetter(key_, static_cast<double>(v));
+            GH_GlobalState::instance().setGetter(handle_, Value::of(static_cast<double>(v)));
         } else {
-            GH_GlobalState::instance().setGetter(key_, v);
+            GH_GlobalState::instance().setGetter(handle_, Value::of(v));
         }
     }
 
 private:
+    static GH_GlobalState::ValueType valueType() {
+        using VT = GH_GlobalState::ValueType;
+        if constexpr (std::is_same_v<T, bool>)               return VT::BOOL;
+        else if constexpr (std::is_same_v<T, int>)           return VT::INT;
+        else if constexpr (std::is_same_v<T, std::string>)   return VT::STRING;
+        else if constexpr (std::is_same_v<T, tools::UnixMs>) return VT::TIME;
+        else                                                 return VT::DOUBLE;
+    }
+
     std::string key_;
+    GH_GlobalState::GetterHandle handle_;
 };
 
 static volatile std::sig_atomic_t g_run = 1;
@@ -296,6 +354,8 @@ int main() {
     // ------------------------------------------------------------
     logic::RuleTree logicTree;
     logic::RuleEngine logicEngine(gs, logicTree);
+    logicEngine.setParallel(GH_LOGIC_THREADS, GH_LOGIC_PARALLEL_MIN);
+    logicEngine.setProfiling(GH_LOGIC_PROFILE != 0);
     logic::LogicJsonController logicJson(logicTree, logicEngine, "logic.json");
 
     try {
@@ -331,6 +391,24 @@ int main() {
         return logicJson.apiReload(body);
     });
 
+    jsonApi.registerGetter("logic/profile", [&]() {
+        std::lock_guard<std::mutex> lock(logicJson.mutex());
+        return api::logicProfileJson(logicEngine);
+    });
+
+    jsonApi.registerSetter("logic/profile", [&](const nlohmann::json& body) {
+        std::lock_guard<std::mutex> lock(logicJson.mutex());
+        return api::logicProfileSetJson(logicEngine, body);
+    });
+
+    jsonApi.registerGetter("history/keys", [&]() {
+        return api::historyKeysJson(gs);
+    });
+
+    jsonApi.registerSetter("history/query", [&](const nlohmann::json& body) {
+        return api::historyQueryJson(gs, body);
+    });
+
     // ------------------------------------------------------------
     // Desired-state API helpers
     // ------------------------------------------------------------
@@ -406,57 +484,203 @@ int main() {
         };
 
     // ------------------------------------------------------------
-    // Boot desired-state demo
+    // Persistent history: every numeric getter / executor write is
+    // buffered and flushed as compressed blocks under history/
+    // ------------------------------------------------------------
+    auto& tsdb = storage::TimeSeriesStore::instance();
+    try {
+        tsdb.open("history");
+        tsdb.start();
+    } catch (const std::exception& ex) {
+        std::cout << "[TSDB] disabled: " << ex.what() << "\n";
+    }
+
+    // ------------------------------------------------------------
+    // State journal: executor desired / actual state is restored
+    // from journal/ before anything runs, so a restart resumes
+    // where it stopped instead of re-driving every relay
     // ------------------------------------------------------------
+    auto& journal = storage::StateJournal::instance();
+    bool warmRestart = false;
     try {
-        {
-            const int id = gs.execIdByName("LOW_DCM_D_0");
-            gs.setExecDesired(id, true,  GH_MODE::AUTO, "boot", true);
-            gs.setExecDesired(id, false, GH_MODE::AUTO, "boot", true);
+        const auto saved = journal.open("journal");
+        const size_t restored = storage::StateJournal::restore(gs, saved);
+        warmRestart = restored > 0;
+        std::cout << "[JOURNAL] restored " << restored << " executors\n";
+
+        journal.start([&gs]() {
+            return storage::StateJournal::fromSnapshot(*gs.execSnapshot());
+        });
+    } catch (const std::exception& ex) {
+        std::cout << "[JOURNAL] disabled: " << ex.what() << "\n";
+    }
+
+    // History series are interned once per slot (startup for what is
+    // registered now, first write for later slots), so the observer
+    // adds no string work to the writer's critical section; tsdb's
+    // SeriesId append is a lock-free ring push. Each vector is only
+    // touched under its table's writer lock, which the observer runs under.
+    using SeriesId = storage::TimeSeriesStore::SeriesId;
+    constexpr SeriesId kNoSeries = std::numeric_limits<SeriesId>::max();
+
+    struct HistorySeriesIds {
+        std::vector<SeriesId> getter;
+        std::vector<SeriesId> desired;
+        std::vector<SeriesId> actual;
+    };
+    auto historyIds = std::make_shared<HistorySeriesIds>();
+
+    auto seriesFor = [&tsdb, kNoSeries](std::vector<SeriesId>& ids, uint32_t slot,
+                                        const std::string& name) {
+        if (slot >= ids.size()) ids.resize(slot + 1, kNoSeries);
+        if (ids[slot] == kNoSeries) ids[slot] = tsdb.seriesId(name);
+        return ids[slot];
+    };
+
+    if (tsdb.isOpen()) {
+        const auto getters = gs.getterSnapshot();
+        for (uint32_t slot = 0; slot < getters->slots.size(); ++slot) {
+            seriesFor(historyIds->getter, slot, getters->slots[slot]->key);
         }
-        {
-            const int id = gs.execIdByName("LOW_DCM_D_1");
-            gs.setExecDesired(id, true,  GH_MODE::AUTO, "boot", true);
-            gs.setExecDesired(id, false, GH_MODE::AUTO, "boot", true);
+
+        const auto execs = gs.execSnapshot();
+        for (uint32_t slot = 0; slot < execs->slots.size(); ++slot) {
+            const std::string& name = execs->slots[slot]->name;
+            seriesFor(historyIds->desired, slot, "exec." + name + ".desired");
+            seriesFor(historyIds->actual, slot, "exec." + name + ".actual");
         }
-        {
-            const int id = gs.execIdByName("LOW_DCM_D_2");
-            gs.setExecDesired(id, true,  GH_MODE::AUTO, "boot", true);
-            gs.setExecDesired(id, false, GH_MODE::AUTO, "boot", true);
+    }
+
+    gs.setWriteObserver([&tsdb, &journal, historyIds, seriesFor](const GH_GlobalState::StateWrite& w) {
+        journal.record(w);
+
+        using VT = GH_GlobalState::ValueType;
+        const auto& v = w.value;
+        if (!tsdb.isOpen() || w.modeOnly || !w.valid) return;
+        if (v.type != VT::BOOL && v.type != VT::INT && v.type != VT::DOUBLE) return;
+        if (!v.hasValue()) return;
+
+        SeriesId series = 0;
+        switch (w.kind) {
+            case GH_GlobalState::StateWriteKind::GETTER:
+                series = seriesFor(historyIds->getter, w.slot, w.name);
+                break;
+            case GH_GlobalState::StateWriteKind::EXEC_DESIRED:
+                series = seriesFor(historyIds->desired, w.slot, "exec." + w.name + ".desired");
+                break;
+            case GH_GlobalState::StateWriteKind::EXEC_ACTUAL:
+                series = seriesFor(historyIds->actual, w.slot, "exec." + w.name + ".actual");
+                break;
+        }
+
+        tsdb.append(series, tools::nowUnixMs(), v.toDouble());
+    });
+
+    // ------------------------------------------------------------
+    // Boot desired-state demo (cold start only)
+    // ------------------------------------------------------------
+    if (warmRestart) {
+        std::cout << "[BOOT] warm restart, desired-state demo skipped\n";
+    } else {
+        try {
+            {
+                const int id = gs.execIdByName("LOW_DCM_D_0");
+                gs.setExecDesired(id, true,  GH_MODE::AUTO, "boot", true);
+                gs.setExecDesired(id, false, GH_MODE::AUTO, "boot", true);
+            }
+            {
+                const int id = gs.execIdByName("LOW_DCM_D_1");
+                gs.setExecDesired(id, true,  GH_MODE::AUTO, "boot", true);
+                gs.setExecDesired(id, false, GH_MODE::AUTO, "boot", true);
+            }
+            {
+                const int id = gs.execIdByName("LOW_DCM_D_2");
+                gs.setExecDesired(id, true,  GH_MODE::AUTO, "boot", true);
+                gs.setExecDesired(id, false, GH_MODE::AUTO, "boot", true);
+            }
+        } catch (...) {
+            std::cout << "[BOOT] startup desired-state demo skipped or partially failed\n";
         }
-    } catch (...) {
-        std::cout << "[BOOT] startup desired-state demo skipped or partially failed\n";
     }
 
     // ------------------------------------------------------------
     // Scheduler
     // ------------------------------------------------------------
-    auto& sch = Scheduler::instance(4);
+    auto& sch = Scheduler::instance(1);
 
-    sch.addPeriodic([&]() {
-        try {
-            dg.tick();
-        } catch (const std::exception& ex) {
-            std::cout << "[DG] error: " << ex.what() << "\n";
-        }
-    }, Scheduler::Ms(1000), "DG tick -> GlobalState");
+    // control: logic / bridge / executor queue only, never blocks.
+    // io: serial (DCM retries up to commandTimeout x retries), curl,
+    // 1-Wire and the HTTP server, which parks one thread for good.
+    // Persistence (tsdb, journal) already has its own flush threads.
+    const auto controlLane = sch.addLane(LaneConfig{"control", 2, GH_CONTROL_LANE_CPUS, GH_CONTROL_LANE_FIFO});
+    const auto ioLane      = sch.addLane(LaneConfig{"io", 3, {}, 0});
 
-    sch.addPeriodic([&]() {
+    // the control cycle stays on its phase grid and drops fires it missed;
+    // device-facing ticks never run concurrently with themselves
+    const Scheduler::PeriodicPolicy phaseLocked{Scheduler::Periodic::FIXED_RATE_SKIP, true, controlLane};
+    const Scheduler::PeriodicPolicy noOverlap{Scheduler::Periodic::FIXED_DELAY, true, ioLane};
+
+    // ------------------------------------------------------------
+    // Control cycle: logic -> bridge -> executor as one task graph,
+    // each stage posted the moment the previous one returns.
+    // Phase-locked at 100 ms, and started right away by every DG
+    // tick so a sensor change reaches the serial queue in one pass.
+    // Deadlines are from cycle start.
+    // ------------------------------------------------------------
+    TaskGraph control;
+    Scheduler::TaskId controlCycle = 0;   // set by addGraph() below
+
+    // ------------------------------------------------------------
+    // Time-driven rules report their next possible edge; the cycle
+    // is triggered right at it instead of on the next 100 ms fire.
+    // One wake is pending at a time, the earliest one.
+    // ------------------------------------------------------------
+    struct {
+        std::mutex mtx;
+        long long at{LLONG_MIN};        // unix ms of the pending wake
+        Scheduler::TaskId task{0};
+    } logicWake;
+
+    auto armLogicWake = [&sch, &logicWake, &controlCycle, controlLane](long long at) {
+        if (at == LLONG_MAX) return;
+
+        std::lock_guard<std::mutex> lk(logicWake.mtx);
+        const long long now = tools::nowUnixMs();
+        const bool pending = logicWake.at > now;
+        if (pending && logicWake.at <= at) return;
+        if (pending) sch.cancel(logicWake.task);
+
+        logicWake.at = at;
+        logicWake.task = sch.addDelayed([&sch, &controlCycle]() {
+            sch.trigger(controlCycle);
+        }, Scheduler::Ms(std::max(0LL, at - now)), "Logic edge wake", controlLane);
+    };
+
+    // set while the logic stage commits; its writes are picked up by
+    // the bridge stage that follows, so they need no wake of their own
+    std::atomic<bool> inLogicStage{false};
+
+    const auto logicStage = control.add("logic", [&]() {
         try {
             std::lock_guard<std::mutex> lock(logicJson.mutex());
+            inLogicStage.store(true, std::memory_order_release);
             logicEngine.tick();
+            inLogicStage.store(false, std::memory_order_release);
+            armLogicWake(logicEngine.nextWakeUnixMs());
         } catch (const std::exception& ex) {
+            inLogicStage.store(false, std::memory_order_release);
             std::cout << "[LOGIC] tick error: " << ex.what() << "\n";
         } catch (...) {
+            inLogicStage.store(false, std::memory_order_release);
             std::cout << "[LOGIC] tick unknown error\n";
         }
-    }, Scheduler::Ms(100), "Logic.tick()");
+    }, Scheduler::Ms(30));
 
-    sch.addPeriodic([&]() {
+    const auto bridgeStage = control.then(logicStage, "bridge", [&]() {
         execBridge.tick();
-    }, Scheduler::Ms(100), "DesiredState bridge -> Executor");
+    }, Scheduler::Ms(50));
 
-    sch.addPeriodic([&]() {
+    control.then(bridgeStage, "executor", [&]() {
         try {
             const bool did = executor.tick();
             if (did) {
@@ -467,7 +691,27 @@ int main() {
         } catch (...) {
             std::cout << "[EXEC] tick() unknown error\n";
         }
-    }, Scheduler::Ms(100), "Executor.tick()");
+    }, Scheduler::Ms(80));
+
+    controlCycle = sch.addGraph(std::move(control), Scheduler::Ms(100),
+                                "Control cycle", phaseLocked);
+
+    sch.addPeriodic([&sch, &dg, controlCycle]() {
+        try {
+            dg.tick();
+        } catch (const std::exception& ex) {
+            std::cout << "[DG] error: " << ex.what() << "\n";
+        }
+        sch.trigger(controlCycle);
+    }, Scheduler::Ms(1000), "DG tick -> GlobalState", noOverlap);
+
+    // desired-state changes from outside the cycle (HTTP) start the
+    // control cycle right away, so its bridge stage is the only one
+    // applying them; the logic stage's own commits are left to it
+    gs.setExecDirtyListener([&sch, &inLogicStage, controlCycle]() {
+        if (inLogicStage.load(std::memory_order_acquire)) return;
+        sch.trigger(controlCycle);
+    });
 
     sch.addPeriodic([&]() {
         try {
@@ -477,7 +721,15 @@ int main() {
         } catch (...) {
             std::cout << "[EXEC] tickStrategies() unknown error\n";
         }
-    }, Scheduler::Ms(300), "Executor.tickStrategies()->DCM");
+    }, Scheduler::Ms(300), "Executor.tickStrategies()->DCM", noOverlap);
+
+    jsonApi.registerGetter("scheduler/stats", [&sch]() {
+        return api::schedulerStatsJson(sch);
+    });
+
+    jsonApi.registerSetter("scheduler/stats/reset", [&sch](const nlohmann::json&) {
+        return api::schedulerStatsResetJson(sch);
+    });
 
     // ------------------------------------------------------------
     // HTTP server
@@ -487,7 +739,7 @@ int main() {
 
     sch.addDelayed([httpServer]() {
         httpServer->run(); // BLOCKING
-    }, Scheduler::Ms(0), "HTTP ioc.run()");
+    }, Scheduler::Ms(0), "HTTP ioc.run()", ioLane);
 
     std::cout << "HTTP server on http://localhost:8080\n";
     std::cout << "Logic file: " << logicJson.filePath() << "\n";
@@ -498,8 +750,13 @@ int main() {
     }
 
     httpServer->stop();
+    gs.setExecDirtyListener(nullptr);
     sch.stop();
 
+    gs.setWriteObserver(nullptr);
+    journal.stop();
+    tsdb.stop();
+
     std::cout << "Stopped.\n";
     return 0;
 }
\ No newline at end of file